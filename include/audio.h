@@ -0,0 +1,29 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdint.h>
+
+//=================================================================
+// Non-blocking buzzer sequencer. playSound() only queues the sound;
+// a 1 kHz timer interrupt steps through the notes, so neither the game
+// loop nor an ISR ever waits on the buzzer.
+
+enum SoundId : uint8_t {
+  SOUND_FOOD_EATEN,
+  SOUND_BAD_FOOD_SHOWN,
+  SOUND_GAME_START,
+  SOUND_GAME_OVER,
+  SOUND_BAD_FOOD_EATEN,
+  SOUND_PAUSE,
+  SOUND_RESUME,
+  SOUND_CLICK,
+  SOUND_COUNT
+};
+
+#define SOUND_QUEUE_SIZE 4  // sounds waiting behind the one playing, extra requests are dropped
+
+void playSound(SoundId sound);  // safe to call from an ISR
+bool audioBusy();
+void audioTick();  // advance the sequencer by 1 ms, called from the HAL clock interrupt
+
+#endif
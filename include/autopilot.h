@@ -0,0 +1,43 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdint.h>
+#include "engine.h"
+
+//=================================================================
+// Computer player, for the attract mode and unattended soak runs.
+//
+// A breadth-first search spreads out from the food over every cell the
+// snake could pass, until it reaches the head. Each cell keeps only its
+// distance from the food modulo 3: neighbouring cells differ by at most
+// one step, so the neighbour one below is always the way to the food.
+// The search runs a bounded number of cells per move, so it may take a
+// few moves to finish, and the field it leaves behind is reused until
+// the food moves or the way ahead gets blocked. When there is no field
+// to follow, the snake heads for the free neighbour with the most room
+// around it.
+
+#define AUTOPILOT_BUDGET 96  // cells the search expands per move, a few thousand cycles
+
+struct Autopilot {
+  uint8_t distance[(GRID_CELLS * 2 + 7) / 8];  // 2 bits per cell: steps to the food mod 3, 3 when not reached
+  OccupancyGrid frontier;  // reached cells still to expand, this wave and the next
+  Cell target;             // food the field leads to
+  uint8_t wave;            // distance mod 3 of the cells being expanded
+  GridByte cursor;         // frontier byte the search resumes at
+  bool grew;               // the current wave reached new cells
+  bool ready;              // the head is in the field, no more searching until it is rebuilt
+  uint16_t followed;       // moves taken along the field, a stale field is dropped after a board's worth
+  uint8_t snake;           // the snake it steers
+};
+
+// Forget any field and take over a snake, the next autopilotThink() starts a search
+void autopilotBegin(Autopilot &pilot, uint8_t snake = 0);
+
+// Spend up to budget cell expansions on the search; call once per move
+void autopilotThink(Autopilot &pilot, const Game &game, uint16_t budget);
+
+// Turn for the next move of its snake, 0 to keep going straight
+char autopilotSteer(Autopilot &pilot, const Game &game);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+//=================================================================
+// Playfield geometry shared by the game loop and the engine modules.
+// A layout is picked at compile time with -DBOARD_LAYOUT=...; every
+// position, wrap and bound below follows from its four numbers, so the
+// code that uses them compiles to constants for each layout.
+
+#define BOARD_PORTRAIT 0   // 240x320 with 10 px cells, 23 x 25 cells: the original board
+#define BOARD_LANDSCAPE 1  // 320x240 with 10 px cells, 31 x 17 cells
+#define BOARD_FINE 2       // 240x320 with 5 px cells, 47 x 51 cells; too big for 2 KB of SRAM
+
+#ifndef BOARD_LAYOUT
+#define BOARD_LAYOUT BOARD_PORTRAIT
+#endif
+
+#if BOARD_LAYOUT == BOARD_PORTRAIT
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 320
+#define SCREEN_ROTATION 0  // setRotation() of the display
+#define CELL_SIZE 10       // every snake segment, food and barrier is one cell
+#elif BOARD_LAYOUT == BOARD_LANDSCAPE
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+#define SCREEN_ROTATION 1
+#define CELL_SIZE 10
+#elif BOARD_LAYOUT == BOARD_FINE
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 320
+#define SCREEN_ROTATION 0
+#define CELL_SIZE 5
+#else
+#error "unknown BOARD_LAYOUT"
+#endif
+
+#define HUD_BAND 30  // px above the playfield frame for level and food timer, and below it for the score
+
+#define X_BOUNDARY CELL_SIZE              // define the area of the screen for gameplay
+#define Y_BOUNDARY (HUD_BAND + CELL_SIZE) // define the area of the screen for gameplay
+
+// Cells the snake head can reach: x from X_BOUNDARY to SCREEN_WIDTH - X_BOUNDARY,
+// y from Y_BOUNDARY to SCREEN_HEIGHT - Y_BOUNDARY (both ends inclusive)
+#define GRID_COLS ((SCREEN_WIDTH - 2 * X_BOUNDARY) / CELL_SIZE + 1)
+#define GRID_ROWS ((SCREEN_HEIGHT - 2 * Y_BOUNDARY) / CELL_SIZE + 1)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+
+// Yellow frame around the playfield. The last column and row of cells
+// reach its right and bottom edges, so erasing them has to restore it.
+#define BORDER_X 0
+#define BORDER_Y HUD_BAND
+#define BORDER_W SCREEN_WIDTH
+#define BORDER_H (Y_BOUNDARY + GRID_ROWS * CELL_SIZE - HUD_BAND)
+
+// One playfield cell, a byte per axis. Game state is kept in cells and
+// pixel positions are only worked out when something is drawn.
+struct Cell {
+  uint8_t col;
+  uint8_t row;
+
+  int16_t x() const { return X_BOUNDARY + col * CELL_SIZE; }
+  int16_t y() const { return Y_BOUNDARY + row * CELL_SIZE; }
+  uint16_t index() const { return row * GRID_COLS + col; }
+
+  bool operator==(const Cell &other) const { return col == other.col && row == other.row; }
+  bool operator!=(const Cell &other) const { return !(*this == other); }
+};
+
+static_assert(GRID_COLS <= 256 && GRID_ROWS <= 256, "a cell keeps one byte per axis");
+
+// The cell of a grid index, row by row from the top left
+inline Cell cellAt(uint16_t index) {
+  Cell cell = { (uint8_t)(index % GRID_COLS), (uint8_t)(index / GRID_COLS) };
+  return cell;
+}
+
+// Smallest unsigned type that counts up to a bound: loops over per-cell
+// tables stay 8-bit on the small boards and widen only when they must
+template<bool fitsByte> struct IndexType { typedef uint8_t type; };
+template<> struct IndexType<false> { typedef uint16_t type; };
+template<uint16_t bound> using IndexFor = typename IndexType<(bound <= 255)>::type;
+
+static_assert(X_BOUNDARY + (GRID_COLS - 1) * CELL_SIZE + CELL_SIZE <= SCREEN_WIDTH, "the last column must be on screen");
+static_assert(BORDER_Y + BORDER_H + HUD_BAND <= SCREEN_HEIGHT, "the score band must fit below the frame");
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+//=================================================================
+// CRC-16/CCITT: polynomial 0x1021, starting from 0xFFFF. Bit by bit,
+// a few dozen cycles per byte and no table in flash. Guards the
+// leaderboard records and the serial telemetry frames.
+
+#define CRC16_START 0xFFFF
+
+inline uint16_t crc16Update(uint16_t crc, uint8_t byte) {
+  crc ^= (uint16_t)byte << 8;
+  for (uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  return crc;
+}
+
+inline uint16_t crc16(const uint8_t *data, uint8_t length) {
+  uint16_t crc = CRC16_START;
+  while (length--) crc = crc16Update(crc, *data++);
+  return crc;
+}
+
+#endif
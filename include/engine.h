@@ -0,0 +1,104 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include "board.h"
+#include "grid.h"
+#include "snake_body.h"
+#include "rng.h"
+#include "levels.h"
+#include "audio.h"
+#include "sprites.h"
+#include "timer_wheel.h"
+
+//=================================================================
+// Game rules. Everything that decides where the snake, food, barriers
+// and bad food are lives here, with no drawing or sound of its own: the
+// engine reports what changed through a GameView. Game time only moves
+// with the snake, one level tick period per move, so a game is fully
+// determined by its seed and the turn taken on each move. The device,
+// the headless simulator and replays all run the same code.
+//
+// A game has one or more snakes; snake 0 is the player's. Every move
+// advances them all together: tails leave, then new heads are checked
+// against the occupancy planes and each other, so a move costs the same
+// per snake however long the bodies are. A snake that crashes leaves the
+// board, and the game is over when the last one crashes, or when one is
+// left standing in a game that started with more.
+
+#define TURN_QUEUE_SIZE 3  // turns waiting for coming moves, further ones are dropped
+
+// Why a snake left the board
+enum Crash : uint8_t {
+  CRASH_NONE,
+  CRASH_BODY,     // into its own body or another snake's
+  CRASH_BARRIER,
+  CRASH_HEAD_ON   // into another snake's head on the same move, or swapping cells with it
+};
+
+// Timed entities, on the game's wheel in game time
+enum GameTimer : uint8_t {
+  TIMER_FOOD,  // the food's lifetime runs out
+  GAME_TIMERS
+};
+
+// What the engine tells the outside world; every member must be set
+struct GameView {
+  void (*erase)(Cell cell);                  // a cell became empty
+  void (*draw)(Cell cell, SpriteId sprite);  // a cell gained an entity
+  void (*sound)(SoundId sound);
+  void (*score)(int points, int level);
+};
+
+struct Game {
+  const GameView *view;
+
+  // Occupancy planes, updated incrementally as the snake and hazards move
+  OccupancyGrid bodyGrid;
+  OccupancyGrid barrierGrid;
+  OccupancyGrid badFoodGrid;
+
+  // Spawn streams, all derived from the seed of the game
+  Rng foodRng;
+  Rng barrierRng;
+  Rng hazardRng;
+
+  SnakeSet snakes;
+  char turns[MAX_SNAKES][TURN_QUEUE_SIZE];  // queued turns of each snake, oldest first, one is taken per move
+  uint8_t turnCount[MAX_SNAKES];
+  unsigned short points[MAX_SNAKES];
+  Crash crash[MAX_SNAKES];
+  unsigned short level;     // follows the best score
+  LevelParams levelParams;  // speed, food lifetime and hazard counts of the current level
+  bool over;                // set by the move that ends the game
+  uint32_t ticks;           // moves made
+  unsigned long clock;      // game time in ms, the sum of the tick periods moved through
+  TimerWheel<GAME_TIMERS> timers;
+
+  Cell food;
+  unsigned long foodSpawnTime;  // game time the food was placed, for its lifetime
+  uint16_t foodMissed;          // foods that timed out before being eaten
+
+  Cell barriers[MAX_BARRIERS];
+  uint8_t barrierCount;
+
+  Cell badFood[MAX_BAD_FOOD];
+  uint8_t badFoodCount;
+};
+
+// Start a game: snakes of one segment, first food, scores of zero.
+// The view's score is the player's, snake 0.
+void gameBegin(Game &game, uint32_t seed, const GameView *view, uint8_t snakes = 1);
+
+// Queue a turn of a snake behind the ones already waiting. A turn that
+// repeats the heading it follows, or reverses it onto the body, is ignored.
+void gameSteer(Game &game, char direction, uint8_t snake = 0);
+
+// Take the next queued turns, move every snake one cell and apply food,
+// bad food, collisions and the food lifetime
+void gameStep(Game &game);
+
+// Put the food on a new free cell
+void gamePlaceFood(Game &game);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdint.h>
+#include "board.h"
+
+//=================================================================
+// Packed one-bit-per-cell occupancy map of the playfield.
+// A plane is GRID_BYTES, 72 bytes for the 23 x 25 portrait board, so
+// body, barrier and bad food each get their own plane and every
+// collision test is one lookup.
+
+#define GRID_BYTES ((GRID_CELLS + 7) / 8)
+
+typedef IndexFor<GRID_BYTES> GridByte;  // counts the bytes of a plane
+
+struct OccupancyGrid {
+  uint8_t bits[GRID_BYTES];
+
+  void clear() {
+    for (GridByte i = 0; i < sizeof(bits); i++) bits[i] = 0;
+  }
+
+  // Add every occupied cell of another plane to this one
+  void merge(const OccupancyGrid &other) {
+    for (GridByte i = 0; i < sizeof(bits); i++) bits[i] |= other.bits[i];
+  }
+
+  // Number of occupied cells
+  uint16_t count() const {
+    uint16_t total = 0;
+    for (GridByte i = 0; i < sizeof(bits); i++) total += __builtin_popcount(bits[i]);
+    return total;
+  }
+
+  bool test(Cell cell) const {
+    uint16_t index = cell.index();
+    return bits[index >> 3] & (1 << (index & 7));
+  }
+
+  void set(Cell cell) {
+    uint16_t index = cell.index();
+    bits[index >> 3] |= (1 << (index & 7));
+  }
+
+  void reset(Cell cell) {
+    uint16_t index = cell.index();
+    bits[index >> 3] &= ~(1 << (index & 7));
+  }
+};
+
+#endif
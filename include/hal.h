@@ -0,0 +1,103 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include "platform.h"
+
+//=================================================================
+// Hardware abstraction layer. The game reaches the board only through
+// these calls: hal_avr.cpp implements them on the ATmega328PB and
+// hal_native.cpp on a Linux host, so the same sources build for both.
+
+// Display: the ILI9341 driver itself on the board, a stand-in with the
+// same drawing calls on the host
+#ifdef ARDUINO
+#include <Adafruit_ILI9341.h>
+typedef Adafruit_ILI9341 Display;
+#else
+#include "host_display.h"
+#endif
+
+void halBegin();  // pins, timers and serial; call once before anything else
+Display &halDisplay();
+
+// The game has sent everything it draws for now. The host display closes
+// its frame there, for per-frame bus traffic and images; nothing to do
+// on the board.
+#ifdef ARDUINO
+inline void halFrameEnd() {}
+#else
+void halFrameEnd();
+#endif
+
+// Input
+#define JOYSTICK_X 0
+#define JOYSTICK_Y 1
+#define AXIS_MAX 1023  // full deflection one way, 0 the other, about half at rest
+
+// Both axes are sampled continuously in the background, so reading
+// them never waits for a conversion
+struct JoystickSample {
+  uint16_t x;
+  uint16_t y;
+};
+
+#define JOYSTICK_BUFFER 8  // samples kept for halNextJoystickSample(), a full buffer drops the oldest
+
+int halReadAxis(uint8_t axis);                     // latest sample of one axis
+bool halNextJoystickSample(JoystickSample &sample);  // oldest unread sample, false when none is left
+bool halButtonDown();
+void halAttachButton(void (*onPress)());  // onPress runs in interrupt context on every press
+
+// Clock
+uint16_t halTicks();        // 1 ms ticks since halBegin(), wraps every 65 s
+unsigned long halMillis();
+void halDelay(unsigned long ms);  // sleeps like halIdle() meanwhile
+void halIdle();             // nothing to do until the next interrupt
+
+// Waiting for the player. The CPU is powered down with every clock
+// stopped, so ticks stand still, no sound plays and the serial port is
+// deaf until it returns. It wakes on the button, and on the watchdog
+// every HAL_SLEEP_POLL_MS to look at the stick; it returns once either
+// was used. While a sound, an EEPROM write or serial output is still
+// going it only idles once instead, so call it in a loop. With
+// -DSNAKE_PROFILE the profiler's wake probe times every press that
+// ends a halIdle() or halSleep(), from the button edge to the return.
+#define HAL_SLEEP_POLL_MS 250
+
+void halSleep();
+
+// Cycle counter for timing code, free-running at the CPU clock
+#define HAL_CYCLES_PER_US 16
+
+uint32_t halCycles();       // wraps every 268 s, differences stay valid
+
+// Serial port, for diagnostics
+void halSerialWrite(const char *text);
+void halSerialWrite(const __FlashStringHelper *text);  // F("...") literal
+int halSerialRead();        // next received byte, -1 when none is waiting
+// Queue bytes for the transmit interrupt, all of them or, when the
+// buffer lacks the room, none; never waits for it to drain
+bool halSerialSend(const uint8_t *data, uint8_t length);
+
+// Audio: a square wave on the buzzer, 0 Hz is silence
+void halTone(uint16_t frequency);
+
+// Persistence: byte-addressed non-volatile memory, erased bytes read 0xFF.
+// Writes run in the background, one byte per EEPROM-ready interrupt, so
+// the 3.3 ms a byte takes never holds up the caller.
+#define HAL_EEPROM_SIZE 1024
+#define HAL_EEPROM_WRITE_MAX 16  // bytes one background write can carry
+
+uint8_t halEepromRead(uint16_t address);  // waits for a background write to finish first
+bool halEepromWrite(uint16_t address, const uint8_t *data, uint8_t length);  // false while busy
+bool halEepromBusy();
+
+// Randomness: a seed that differs from one power-up to the next
+uint32_t halEntropy();
+
+// Hold off interrupts around state shared with a handler; nests
+uint8_t halLock();
+void halUnlock(uint8_t state);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef HOST_DISPLAY_H
+#define HOST_DISPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "platform.h"
+
+//=================================================================
+// Host stand-in for the Adafruit_ILI9341 driver. It offers the subset
+// of drawing calls the game makes, with the same signatures, so the
+// game code compiles unchanged. The pixels land in an RGB565 frame
+// buffer, and every call counts the bus traffic the driver would send
+// for it: transactions, command bytes, address windows and data bytes,
+// with the driver's own shortcuts (unchanged column or page ranges are
+// not sent again, text is drawn pixel by pixel). A frame runs from one
+// endFrame() to the next; its traffic is turned into bus time with a
+// simple model of the AVR's SPI port, and the frame can be saved as an
+// image for comparing runs.
+
+#define ILI9341_BLACK 0x0000
+#define ILI9341_BLUE 0x001F
+#define ILI9341_RED 0xF800
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_YELLOW 0xFFE0
+#define ILI9341_WHITE 0xFFFF
+#define ILI9341_ORANGE 0xFD20
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+// Bus cost model. The AVR sends a byte, then polls for it to finish
+// before loading the next, which leaves a few idle SPI clocks per byte;
+// a transaction also pays for chip select and the SPI settings.
+#define DISPLAY_SPI_HZ 8000000UL   // fastest SPI clock of a 16 MHz AVR
+#define DISPLAY_BYTE_GAP 2         // idle SPI clocks between bytes
+#define DISPLAY_TRANSACTION_NS 1500
+
+// Bus traffic the real driver would cause
+struct DisplayTraffic {
+  uint32_t transactions;  // startWrite() ... endWrite() spans
+  uint32_t commands;      // command bytes, sent with D/C low
+  uint32_t windows;       // address windows opened for a pixel write
+  uint32_t dataBytes;     // command parameters and pixels
+  uint32_t pixels;
+
+  void add(const DisplayTraffic &other);
+  uint32_t busMicros(uint32_t spiHz) const;  // estimated time on the bus
+};
+
+class Display {
+public:
+  Display();
+
+  void begin(uint32_t freq = 0);
+  void setRotation(uint8_t rotation);
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  // Shapes
+  void fillScreen(uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  // Batched writes, only valid between startWrite() and endWrite()
+  void startWrite();
+  void endWrite();
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true, bool bigEndian = false);
+
+  // Text in the built-in 6x8 font
+  void setCursor(int16_t x, int16_t y);
+  void setTextColor(uint16_t color);
+  void setTextColor(uint16_t color, uint16_t background);
+  void setTextSize(uint8_t size);
+  void print(const char *text);
+  void print(const __FlashStringHelper *text);
+  void print(int value);
+  void print(unsigned int value);
+  void print(long value);
+  void print(unsigned long value);
+
+  // Emulator only
+  void record(const char *frameDirectory, FILE *frameLog, uint32_t spiHz);  // where frames and their traffic go, 0 for nowhere
+  void endFrame();                      // close the frame: count it, log it and save its image
+  void report(FILE *out) const;         // traffic of the whole run, per frame
+  uint16_t pixel(int16_t x, int16_t y) const { return frame[y * _width + x]; }
+
+private:
+  void drawChar(int16_t x, int16_t y, char c);
+  void writePixel(int16_t x, int16_t y, uint16_t color);
+  void writeColor(uint16_t color, uint32_t count);
+  void store(uint16_t color);
+  bool saveFrame(const char *path) const;
+
+  uint16_t frame[ILI9341_TFTWIDTH * ILI9341_TFTHEIGHT];  // row by row in the current rotation
+  int16_t _width, _height;
+  int16_t cursorX, cursorY;
+  uint16_t textColor, textBackground;
+  uint8_t textSize;
+  uint8_t rotation;
+
+  // Controller state: the open address window and where the next pixel goes
+  uint16_t windowX1, windowX2, windowY1, windowY2;
+  uint16_t writeX, writeY;
+  uint16_t sentX1, sentX2, sentY1, sentY2;  // ranges the driver last sent, it skips repeats
+
+  DisplayTraffic traffic;  // of the frame being drawn
+  DisplayTraffic total;
+  uint32_t frames;          // frames with any traffic
+  uint32_t worstMicros;     // bus time of the busiest frame
+  uint32_t worstFrame;
+  bool changed;             // pixels written since the last endFrame()
+
+  const char *frameDirectory;
+  FILE *frameLog;
+  uint32_t spiHz;
+};
+
+#endif
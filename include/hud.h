@@ -0,0 +1,39 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "board.h"
+
+//=================================================================
+// Heads-up display. Labels are printed once per game; numbers are
+// drawn from pre-rasterised 12x16 digit glyphs (the built-in font at
+// text size 2) and only the digits that changed are rewritten, each
+// with one address window and no clearing fill.
+
+#define HUD_GLYPH_W 12
+#define HUD_GLYPH_H 16
+
+// Label positions, numbers follow their label on the same line. Level
+// and food timer share the band above the playfield, the score has the
+// one below it.
+#define HUD_SCORE_X 80
+#define HUD_SCORE_Y (BORDER_Y + BORDER_H + 10)
+#define HUD_LEVEL_X 20
+#define HUD_LEVEL_Y 10
+#define HUD_COUNTDOWN_X (SCREEN_WIDTH - 100)
+#define HUD_COUNTDOWN_Y 10
+
+// x that centres a string literal of the built-in 6x8 font, as getTextBounds()
+// would measure it. Only its sizeof is taken, so the literal itself can stay in flash.
+#define CENTERED_X(text, size) ((SCREEN_WIDTH - (int16_t)(sizeof(text) - 1) * 6 * (size)) / 2)
+
+void hudBegin(Display &display);
+void hudReset();                       // draw the static labels for a new game
+void hudClear();                       // take the labels and numbers off the screen again
+void hudSetScore(unsigned int points);
+void hudSetLevel(unsigned int level);
+void hudSetCountdown(unsigned int seconds);
+void hudCountdownMissed();
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+#include "hal.h"
+
+//=================================================================
+// Persistent top scores. Every change appends a whole CRC-checked
+// record to the next slot of a ring in EEPROM, so the writes spread
+// over all slots instead of wearing out one cell. A record that was
+// cut short by a power loss fails its CRC and the one before it counts.
+// At boot the newest record that checks out is taken.
+
+#define LEADERBOARD_SIZE 5
+#define LEADERBOARD_ADDRESS 16  // the old single high score stays at 0
+#define LEADERBOARD_SLOT 16     // bytes per record slot
+#define LEADERBOARD_SLOTS 32    // 512 bytes, each slot rewritten every 32nd change
+
+void leaderboardBegin();                    // find the newest valid record
+uint16_t leaderboardScore(uint8_t rank);    // rank 0 is the best, 0 when empty
+uint8_t leaderboardSubmit(uint16_t points); // rank taken, LEADERBOARD_SIZE when it did not place
+void leaderboardPoll();                     // start saving a change once the EEPROM is free
+
+#endif
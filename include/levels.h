@@ -0,0 +1,24 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include <stdint.h>
+
+//=================================================================
+// Difficulty curve. One row per level, generated at compile time and
+// kept in flash; the game copies a row into RAM when the level changes.
+
+#define MAX_LEVEL 52     // bad food keeps growing until this level, later levels reuse the last row
+#define MAX_BAD_FOOD 50  // upper bound for LevelParams::badFoodCount
+#define MAX_BARRIERS 4   // upper bound for LevelParams::barrierCount
+
+struct LevelParams {
+  uint16_t tickPeriod;    // ms between snake moves
+  uint16_t foodLifetime;  // ms before uneaten food disappears, 0 keeps it forever
+  uint8_t badFoodCount;   // bad foods placed each time the food is eaten
+  uint8_t barrierCount;   // barriers placed each time the food is eaten
+};
+
+// Copy the row for a level (1-based, clamped to MAX_LEVEL) out of flash
+void loadLevel(unsigned int level, LevelParams &params);
+
+#endif
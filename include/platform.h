@@ -0,0 +1,30 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+
+//=================================================================
+// Flash access. On the AVR, tables marked PROGMEM stay in flash and are
+// read back with pgm_read_*(); on the host flash is ordinary memory.
+
+#ifdef ARDUINO
+#include <avr/pgmspace.h>
+#else
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define memcpy_P memcpy
+#endif
+
+// String literals wrapped in F() stay in flash, like tables; on the host
+// the wrapper only tags the type so the flash overloads are picked
+#ifdef ARDUINO
+#include <WString.h>
+#else
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+//=================================================================
+// Hot-path profiler. PROFILE(probe) at the top of a block times the
+// rest of the block in CPU cycles. Each probe keeps its call count,
+// min/avg/max and a histogram with one bucket per factor of four, all
+// in a fixed table. A 'p' on the serial port prints the report and an
+// 'r' clears it. Without -DSNAKE_PROFILE every probe and call compiles
+// to nothing.
+
+enum ProbeId : uint8_t {
+  PROBE_INPUT,         // joystick samples turned into turns
+  PROBE_STEP,          // one snake move with collisions, includes PROBE_SPAWN
+  PROBE_SPAWN,         // placing food, barriers and bad food
+  PROBE_RENDER_QUEUE,  // renderRect() and renderSprite()
+  PROBE_RENDER_FLUSH,  // renderFlush(), the SPI transfer
+  PROBE_HUD,           // one HUD number update
+  PROBE_AUDIO,         // one sequencer tick, in the timer interrupt
+  PROBE_AUTOPILOT,     // one move's share of the autopilot search
+  PROBE_WAKE,          // button press to the sleeping wait returning, with the oscillator start-up
+  PROBE_COUNT
+};
+
+#define PROFILE_BUCKETS 8  // < 64, < 256, < 1k, ... cycles, the last one is open ended
+
+#ifdef SNAKE_PROFILE
+
+void profilerRecord(ProbeId probe, uint32_t cycles);
+void profilerReset();
+void profilerReport();
+uint32_t profilerNow();
+
+struct ProfileScope {
+  ProbeId probe;
+  uint32_t start;
+
+  ProfileScope(ProbeId id) : probe(id), start(profilerNow()) {}
+  ~ProfileScope() { profilerRecord(probe, profilerNow() - start); }
+};
+
+#define PROFILE_JOIN(a, b) a##b
+#define PROFILE_NAME(line) PROFILE_JOIN(profileScope, line)
+#define PROFILE(probe) ProfileScope PROFILE_NAME(__LINE__)(probe)
+
+#else
+
+inline void profilerReset() {}
+inline void profilerReport() {}
+
+#define PROFILE(probe)
+
+#endif
+
+#endif
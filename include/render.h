@@ -0,0 +1,26 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "sprites.h"
+
+//=================================================================
+// Playfield render queue. Drawing calls made during a frame are only
+// recorded; renderFlush() sends them all inside one startWrite()/endWrite()
+// span. Touching solid rects of the same colour are merged first, so a
+// frame costs one SPI transaction and as few address windows as possible.
+
+#define RENDER_QUEUE_SIZE 16  // a full queue is flushed early rather than dropping items
+
+enum RenderKind : uint8_t {
+  RENDER_RECT,    // solid rectangle, also how entities are erased
+  RENDER_SPRITE   // one cell image from the sprite atlas
+};
+
+void renderBegin(Display &display);
+void renderRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void renderSprite(int16_t x, int16_t y, SpriteId sprite);
+void renderFlush();
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include "engine.h"
+
+//=================================================================
+// Replays. A game is fully determined by its seed and the moves on which
+// the snake changed heading, so that is all a replay keeps:
+//
+//   header   'S' 'R' version, seed (4 bytes, low byte first)
+//   turn     one byte: new heading in bits 7-6 (r l u d), bits 5-0 the
+//            moves since the earliest tick this turn could have come;
+//            62 there means a LEB128 varint with the rest follows
+//   end      0x3F, then the move count as a varint and the final score
+//            (2 bytes), which playback checks to catch rule changes
+//
+// A typical turn is one byte. Recording stops quietly when the buffer
+// fills; such a replay has no end marker and is played unverified.
+// Only games of one snake are recorded.
+
+#define REPLAY_VERSION 1
+#define REPLAY_CAPACITY 128  // bytes, about 110 turns
+#define REPLAY_HEADER 7
+
+struct Replay {
+  uint8_t bytes[REPLAY_CAPACITY];
+  uint16_t length;
+  bool truncated;      // ran out of room, the end marker is missing
+  uint32_t nextTick;   // earliest move the next turn can be on
+  char heading;        // heading after the last recorded turn
+};
+
+// Start recording a game about to begin from seed
+void replayStart(Replay &replay, uint32_t seed);
+
+// Call after every gameStep(): records the turn taken on that move, if any
+void replayRecord(Replay &replay, const Game &game);
+
+// Call once the game is over
+void replayFinish(Replay &replay, const Game &game);
+
+struct ReplayReader {
+  const uint8_t *bytes;
+  uint16_t length;
+  uint16_t position;
+  uint32_t seed;
+  uint32_t nextTick;       // move the pending turn is due on
+  char nextHeading;        // pending turn, 0 when none is left
+  bool verified;           // the replay ends with a move count and score to check
+  uint32_t finalTicks;
+  uint16_t finalPoints;
+};
+
+// Check the header and read the first turn; false when it is not a replay
+bool replayOpen(ReplayReader &reader, const uint8_t *bytes, uint16_t length);
+
+// Call before every gameStep(): queues the turn recorded for that move
+void replaySteer(ReplayReader &reader, Game &game);
+
+// The game is over, or has gone on past the move the recording ended on
+bool replayDone(const ReplayReader &reader, const Game &game);
+
+// After the game: true when it ended where the recording did
+bool replayMatches(const ReplayReader &reader, const Game &game);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef REPLAY_STORE_H
+#define REPLAY_STORE_H
+
+#include <stdint.h>
+#include "replay.h"
+
+//=================================================================
+// The last game played, kept in EEPROM after the leaderboard ring so it
+// survives a power cycle. Saving runs in the background a chunk at a
+// time; the length is cleared first and written last, so a save cut
+// short leaves no replay rather than a broken one.
+
+#define REPLAY_STORE_ADDRESS 528  // right after the leaderboard ring
+
+extern Replay lastReplay;  // recorded into during play, saved and loaded from here
+
+void replayStoreBegin();  // load the saved replay, empty when there is none
+void replayStoreSave();   // start saving lastReplay
+void replayStorePoll();   // write the next chunk once the EEPROM is free
+bool replayStoreBusy();   // a save is under way, lastReplay must not change
+void replayStoreDump();   // send lastReplay over serial as "replay <hex>"
+
+#endif
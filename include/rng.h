@@ -0,0 +1,42 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+//=================================================================
+// Small xorshift32 generator. Integer only, a handful of shifts per draw,
+// so every spawn costs the same and a game replays exactly from its seed.
+
+struct Rng {
+  uint32_t state;
+
+  // Derive an independent stream from a game seed, one per stream id
+  void seed(uint32_t gameSeed, uint8_t stream) {
+    uint32_t z = gameSeed + 0x9E3779B9UL * (stream + 1);
+    z = (z ^ (z >> 16)) * 0x45D9F3BUL;
+    z = (z ^ (z >> 16)) * 0x45D9F3BUL;
+    z ^= z >> 16;
+    state = z ? z : 0x2545F491UL;  // xorshift must never hold zero
+  }
+
+  uint32_t next() {
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+  }
+
+  // Value in [0, bound) without a division: scale the top 16 bits
+  uint16_t below(uint16_t bound) {
+    return ((next() >> 16) * (uint32_t)bound) >> 16;
+  }
+};
+
+// Stream ids, so food, barriers and hazards never disturb each other's sequence
+#define RNG_STREAM_FOOD 0
+#define RNG_STREAM_BARRIER 1
+#define RNG_STREAM_HAZARD 2
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include "hal.h"
+
+//=================================================================
+// Fixed-timestep scheduler. The HAL clock counts exact 1 ms ticks; each
+// cadence remembers when it last ran and is polled against that clock,
+// so input, simulation and rendering run at their own rates with no
+// delay() in the loop.
+
+#define INPUT_PERIOD 5        // ms between joystick samples
+#define RENDER_PERIOD 50      // ms between redraws of static playfield items
+#define MENU_PERIOD 200       // ms between menu moves, keeps navigation readable
+#define MAX_CATCHUP_STEPS 4   // simulation steps run back to back before lag is dropped
+
+struct Cadence {
+  uint16_t period;  // ms
+  uint16_t last;    // tick the cadence was last due
+
+  void start(uint16_t periodMs, uint16_t now) {
+    period = periodMs;
+    last = now;
+  }
+
+  // Time accumulated since the cadence last ran
+  uint16_t lag(uint16_t now) const { return now - last; }
+
+  // For sampling and drawing: fire once, forgetting any extra lag
+  bool due(uint16_t now) {
+    if (lag(now) < period) return false;
+    last = now;
+    return true;
+  }
+
+  // For the simulation: consume exactly one period per call so the
+  // number of steps matches the time that passed
+  bool step(uint16_t now) {
+    if (lag(now) < period) return false;
+    last += period;
+    return true;
+  }
+
+  // Drop the accumulated lag, e.g. after a pause
+  void resync(uint16_t now) { last = now; }
+};
+
+inline uint16_t schedulerNow() { return halTicks(); }  // wraps every 65 s
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "engine.h"
+#include "replay.h"
+
+//=================================================================
+// Headless simulator. Runs the engine with a view that draws and plays
+// nothing, so games run as fast as the CPU allows and replay exactly
+// from their seed and input.
+
+struct SimStats {
+  uint32_t ticks;         // moves simulated
+  uint32_t games;         // games started
+  uint32_t foodEaten;
+  uint32_t badFoodEaten;
+  uint16_t bestScore;
+  uint16_t maxLength;
+  uint16_t peakLevel;     // highest level of the current game, bad food can lower the level again
+  bool scoreWrapped;      // bad food at score 0 wrapped the score of the current game to 65535
+  uint32_t checksum;      // folds in every head position and score, equal runs give equal sums
+};
+
+struct Sim {
+  Game game;
+  uint32_t seed;          // seed of the next game
+  uint8_t snakes;         // snakes in every game, snake 0 is the one steered and counted
+  SimStats stats;
+};
+
+// Scripted input, one character per move and repeated when it runs out:
+// 'r', 'l', 'u' or 'd' turns, '.' keeps going
+struct SimScript {
+  const char *moves;
+  uint16_t length;
+  uint16_t position;
+
+  char next() {
+    char move = moves[position];
+    if (++position == length) position = 0;
+    return move == '.' ? 0 : move;
+  }
+};
+
+// Greedy steering for a snake: toward the food along the longer gap
+// first, then any free cell; 0 when every way is blocked
+char simChase(const Game &game, uint8_t snake);
+
+// Clear the stats and start the first game from seed
+void simBegin(Sim &sim, uint32_t seed, uint8_t snakes = 1);
+
+// Start the next game, seeds count up from the first one
+void simNewGame(Sim &sim);
+
+// One move, turning first unless direction is 0; false when it ended the game
+bool simTick(Sim &sim, char direction);
+
+// Play ticks moves from a script, starting a new game whenever one ends
+void simRun(Sim &sim, SimScript &script, uint32_t ticks);
+
+// Play a recorded game through to its end, or for at most ticks moves
+// when it ends without a check; true when it ends where the recording did
+bool simReplay(Sim &sim, ReplayReader &reader, uint32_t ticks);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SNAKE_BODY_H
+#define SNAKE_BODY_H
+
+#include <stdint.h>
+#include "board.h"
+
+// The link pool can hold snakes covering the whole board
+#define MAX_SNAKE_LENGTH GRID_CELLS
+
+// Snakes a game can have: the player and a rival on the device, the
+// bench raises it for its crowded scenario
+#ifndef MAX_SNAKES
+#define MAX_SNAKES 2
+#endif
+
+//=================================================================
+// Snake body
+
+// Move a cell one step in direction 'r', 'l', 'u' or 'd' and continue through the walls
+inline void stepCell(Cell &cell, char direction) {
+  switch (direction) {
+    case 'r':
+      if (++cell.col == GRID_COLS) cell.col = 0;
+      break;
+    case 'l':
+      if (cell.col-- == 0) cell.col = GRID_COLS - 1;
+      break;
+    case 'u':
+      if (cell.row-- == 0) cell.row = GRID_ROWS - 1;
+      break;
+    case 'd':
+      if (++cell.row == GRID_ROWS) cell.row = 0;
+      break;
+  }
+}
+
+// Every snake on the board, stored field by field so a move touches a few
+// bytes per snake and never walks a body. Each link is the 2-bit direction
+// from one segment to the next, so only the head and tail positions are
+// stored. The links of all snakes share one pool the size of the board,
+// GRID_CELLS / 4 bytes (144 on the portrait board), split into equal
+// slices that each snake uses as a ring: growing, moving and shrinking
+// each touch one slot and never shift a body.
+struct SnakeSet {
+  uint8_t links[(MAX_SNAKE_LENGTH * 2 + 7) / 8];
+  uint8_t count;                  // snakes in the game
+  uint16_t capacity;              // links per slice, the longest any snake can grow
+  Cell head[MAX_SNAKES];
+  Cell tail[MAX_SNAKES];
+  char direction[MAX_SNAKES];     // 'r', 'l', 'u' or 'd', heading of the last move
+  uint16_t length[MAX_SNAKES];
+  uint16_t headLink[MAX_SNAKES];  // slot of its slice the next head move is written to
+  uint16_t tailLink[MAX_SNAKES];  // slot of its slice holding the direction the tail moves next
+  bool alive[MAX_SNAKES];         // cleared when the snake crashes
+
+  // Split the pool between snakes; each is placed with place() afterwards
+  void reset(uint8_t snakes) {
+    count = snakes;
+    capacity = MAX_SNAKE_LENGTH / snakes;
+  }
+
+  // Put a snake of one segment on start
+  void place(uint8_t snake, Cell start, char heading) {
+    head[snake] = start;
+    tail[snake] = start;
+    direction[snake] = heading;
+    length[snake] = 1;
+    headLink[snake] = 0;
+    tailLink[snake] = 0;
+    alive[snake] = true;
+  }
+
+  // Move the head one cell forward, the body grows by one segment
+  void pushHead(uint8_t snake, char heading) {
+    uint16_t link = snake * capacity + headLink[snake];
+    uint8_t shift = (link & 3) * 2;
+    uint8_t &slot = links[link >> 2];
+    slot = (slot & ~(3 << shift)) | (directionCode(heading) << shift);
+    if (++headLink[snake] == capacity) headLink[snake] = 0;
+    stepCell(head[snake], heading);
+    length[snake]++;
+  }
+
+  // Drop the last segment, the tail follows the link it was stored with
+  void popTail(uint8_t snake) {
+    if (length[snake] <= 1) return;
+    uint16_t link = snake * capacity + tailLink[snake];
+    uint8_t code = (links[link >> 2] >> ((link & 3) * 2)) & 3;
+    if (++tailLink[snake] == capacity) tailLink[snake] = 0;
+    stepCell(tail[snake], "rlud"[code]);
+    length[snake]--;
+  }
+
+  static uint8_t directionCode(char direction) {
+    switch (direction) {
+      case 'l': return 1;
+      case 'u': return 2;
+      case 'd': return 3;
+      default:  return 0;
+    }
+  }
+};
+
+#endif
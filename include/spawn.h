@@ -0,0 +1,22 @@
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <stdint.h>
+#include "grid.h"
+#include "rng.h"
+
+//=================================================================
+// Spawn sampler. The free cells are the clear bits of a blocked mask
+// built from the occupancy planes, and a pick is a rank-select over
+// that mask: count the free cells, draw a rank, walk to it. Both passes
+// cover the GRID_BYTES of the map once (72 on the portrait board), so
+// the cost is the same on an empty board and a nearly full one and no
+// retry loop is needed.
+
+// Uniformly pick a cell that is clear in blocked, or -1 when none is left
+int16_t pickFreeCell(const OccupancyGrid &blocked, Rng &rng);
+
+// Same as pickFreeCell, writing the cell; it is left alone on a full board
+bool placeInFreeCell(const OccupancyGrid &blocked, Rng &rng, Cell &cell);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include <stdint.h>
+#include "board.h"
+
+//=================================================================
+// Sprite atlas. Every entity is one prebuilt CELL_SIZE x CELL_SIZE
+// image in flash, stored as 2-bit palette indices with a four-colour
+// RGB565 palette, so a draw is one address window and one pixel burst.
+
+enum SpriteId : uint8_t {
+  SPRITE_SNAKE,
+  SPRITE_FOOD,
+  SPRITE_BAD_FOOD,
+  SPRITE_BARRIER,
+  SPRITE_COUNT
+};
+
+#define SPRITE_ROW_BYTES ((CELL_SIZE + 3) / 4)
+
+struct Sprite {
+  uint16_t palette[4];
+  uint8_t rows[CELL_SIZE][SPRITE_ROW_BYTES];
+};
+
+extern const Sprite spriteAtlas[SPRITE_COUNT];
+
+// Copy the four palette colours of a sprite out of flash
+void spritePalette(SpriteId sprite, uint16_t *palette);
+
+// Expand one row of a sprite from flash into CELL_SIZE RGB565 pixels
+void spriteRow(SpriteId sprite, uint8_t row, const uint16_t *palette, uint16_t *pixels);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "engine.h"
+
+//=================================================================
+// Binary telemetry and remote control over the serial port. Each move
+// sends one frame with only what changed on the board: the cells erased
+// and drawn, which covers the head, the tail and every spawn, and the
+// score when it changed. A host reader rebuilds the board from those.
+// Frames go out through the serial transmit interrupt and are dropped
+// when its buffer is full. After a drop the board is sent again a chunk
+// at a time, so the host catches up without the game ever waiting. A
+// host can send frames back that steer and press the button in place
+// of the joystick. Text diagnostics share the port; the CRC tells the
+// two apart. scripts/telemetry_reader.py is the host side.
+//
+// Frame, both ways:
+//   0x7E  type  sequence  length  payload...  CRC-16 (low byte first)
+// The CRC covers type to the end of the payload. Sequence counts frames
+// sent, so the host can spot a gap.
+
+#define TELEMETRY_SYNC 0x7E
+#define TELEMETRY_PAYLOAD_MAX 48  // a whole frame fits the transmit buffer of 64 bytes
+#define TELEMETRY_CHUNK_CELLS 64  // cells per snapshot frame, two per byte
+
+enum TelemetryFrame : uint8_t {
+  // Device to host
+  FRAME_BEGIN = 1,  // a game starts: cols, rows, seed (4 bytes), play mode
+  FRAME_TICK,       // a move: tick (2 bytes), then ops
+  FRAME_SNAPSHOT,   // first cell index (2 bytes), cols, rows, then a nibble per cell, sprite + 1 or 0 for empty
+
+  // Host to device
+  FRAME_STEER = 0x10,  // a direction, 'u', 'd', 'l' or 'r'
+  FRAME_BUTTON,        // a press of the button
+  FRAME_RESYNC         // send the whole board again
+};
+
+// Ops in a FRAME_TICK. Numbers go low byte first.
+#define OP_ERASE 0x00  // then col, row
+#define OP_DRAW 0x10   // + sprite, then col, row
+#define OP_SCORE 0x20  // then points (2 bytes), level
+
+// What a received byte meant
+enum Remote : uint8_t {
+  REMOTE_TEXT,    // not part of a frame: a text command
+  REMOTE_NONE,    // part of a frame, nothing to do yet
+  REMOTE_STEER,   // telemetryRemoteTurn() says where
+  REMOTE_BUTTON
+};
+
+// A game starts, on a board that is empty until the game draws on it.
+// Call it before gameBegin(), and telemetryTick() after.
+void telemetryBegin(const Game &game, uint32_t seed, uint8_t mode);
+
+// The game's view of the board, alongside the screen's
+void telemetryErase(Cell cell);
+void telemetryDraw(Cell cell, SpriteId sprite);
+void telemetryScore(int points, int level);
+
+void telemetryTick();  // send what the last move changed
+void telemetryPoll();  // send the next part of a snapshot if one is due and fits
+
+Remote telemetryReceive(uint8_t byte);
+char telemetryRemoteTurn();
+bool telemetryLinked();  // a host has sent a valid frame since power-up
+
+#endif
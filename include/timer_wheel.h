@@ -0,0 +1,84 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+//=================================================================
+// Hashed timer wheel for timed entities. Every timer is a fixed slot,
+// numbered by its owner, linked into the bucket its deadline falls in,
+// so scheduling and cancelling touch one bucket. Moving the clock on
+// visits only the buckets it passes: timers that are not due cost
+// nothing, however many are waiting. A deadline more than one turn of
+// the wheel away shares its bucket with nearer ones and is passed over
+// until its turn comes round.
+
+#define WHEEL_BUCKETS 8  // a power of two
+#define WHEEL_GRAIN 5    // each bucket covers 2^5 = 32 ms
+#define WHEEL_NONE 0xFF
+
+template<uint8_t timers>
+struct TimerWheel {
+  uint32_t now;                // ms, how far expire() has run
+  uint32_t deadline[timers];
+  uint8_t bucket[timers];      // where each timer is linked, WHEEL_NONE when idle
+  uint8_t next[timers];        // neighbours in the bucket, WHEEL_NONE at the ends
+  uint8_t prev[timers];
+  uint8_t first[WHEEL_BUCKETS];
+  uint8_t armed;               // timers linked in, an empty wheel skips the walk
+
+  static uint8_t bucketOf(uint32_t ms) { return (ms >> WHEEL_GRAIN) & (WHEEL_BUCKETS - 1); }
+
+  void reset(uint32_t start) {
+    now = start;
+    armed = 0;
+    for (uint8_t i = 0; i < WHEEL_BUCKETS; i++) first[i] = WHEEL_NONE;
+    for (uint8_t i = 0; i < timers; i++) bucket[i] = WHEEL_NONE;
+  }
+
+  bool pending(uint8_t timer) const { return bucket[timer] != WHEEL_NONE; }
+
+  // Set or move a timer's deadline. One already due goes in the bucket
+  // expire() looks at next.
+  void schedule(uint8_t timer, uint32_t at) {
+    cancel(timer);
+    deadline[timer] = at;
+    uint8_t b = bucketOf((int32_t)(at - now) > 0 ? at : now);
+    bucket[timer] = b;
+    prev[timer] = WHEEL_NONE;
+    next[timer] = first[b];
+    if (first[b] != WHEEL_NONE) prev[first[b]] = timer;
+    first[b] = timer;
+    armed++;
+  }
+
+  void cancel(uint8_t timer) {
+    if (!pending(timer)) return;
+    if (prev[timer] != WHEEL_NONE) next[prev[timer]] = next[timer];
+    else first[bucket[timer]] = next[timer];
+    if (next[timer] != WHEEL_NONE) prev[next[timer]] = prev[timer];
+    bucket[timer] = WHEEL_NONE;
+    armed--;
+  }
+
+  // Run the clock up to `to` and take one timer that is due by then off
+  // the wheel; WHEEL_NONE once none is left. Call it in a loop.
+  uint8_t expire(uint32_t to) {
+    // Each bucket is checked against `to` itself, so after one turn every
+    // due timer has been seen and the rest of a long jump can be skipped
+    for (uint8_t visited = 0; armed && visited < WHEEL_BUCKETS; visited++) {
+      for (uint8_t t = first[bucketOf(now)]; t != WHEEL_NONE; t = next[t]) {
+        if ((int32_t)(deadline[t] - to) <= 0) {
+          cancel(t);
+          return t;
+        }
+      }
+      uint32_t following = (now | ((1UL << WHEEL_GRAIN) - 1)) + 1;  // start of the next bucket
+      if ((int32_t)(following - to) > 0) break;
+      now = following;
+    }
+    now = to;
+    return WHEEL_NONE;
+  }
+};
+
+#endif
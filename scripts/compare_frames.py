@@ -0,0 +1,67 @@
+# Golden-image check for the host display. Compares two directories of
+# frames saved by the native build ($SNAKE_FRAMES) and lists every frame
+# that is missing from one side or differs, with the number of pixels
+# that changed and their bounding box. Exits with 1 when anything
+# differs, so it can gate a render change:
+#
+#   SNAKE_SEED=1 SNAKE_CLOCK=virtual SNAKE_FRAMES=golden .pio/build/native/program < input.txt
+#   ...change the renderer, rebuild...
+#   SNAKE_SEED=1 SNAKE_CLOCK=virtual SNAKE_FRAMES=new .pio/build/native/program < input.txt
+#   python3 scripts/compare_frames.py golden new
+
+import os
+import sys
+
+
+def read_ppm(path):
+    # Binary PPM as the emulator writes it: P6, width height, 255
+    with open(path, "rb") as image:
+        data = image.read()
+    magic, size, depth, pixels = data.split(b"\n", 3)
+    if magic != b"P6" or depth != b"255":
+        raise ValueError("%s: not a binary PPM" % path)
+    width, height = (int(n) for n in size.split())
+    return width, height, pixels
+
+
+def difference(golden, new):
+    # Changed pixels and their bounding box, or None for a size change
+    width, height, before = golden
+    if (width, height) != new[:2]:
+        return None
+    after = new[2]
+    changed = 0
+    box = [width, height, -1, -1]
+    for i in range(0, len(before), 3):
+        if before[i:i + 3] != after[i:i + 3]:
+            x, y = (i // 3) % width, (i // 3) // width
+            changed += 1
+            box = [min(box[0], x), min(box[1], y), max(box[2], x), max(box[3], y)]
+    return changed, box
+
+
+def main(golden_dir, new_dir):
+    golden = set(f for f in os.listdir(golden_dir) if f.endswith(".ppm"))
+    new = set(f for f in os.listdir(new_dir) if f.endswith(".ppm"))
+    failed = 0
+    for name in sorted(golden | new):
+        if name not in new or name not in golden:
+            print("%s: only in %s" % (name, golden_dir if name in golden else new_dir))
+            failed += 1
+            continue
+        result = difference(read_ppm(os.path.join(golden_dir, name)), read_ppm(os.path.join(new_dir, name)))
+        if result is None:
+            print("%s: size differs" % name)
+            failed += 1
+        elif result[0]:
+            print("%s: %d pixels differ in %d,%d .. %d,%d" % ((name, result[0]) + tuple(result[1])))
+            failed += 1
+    print("%d of %d frames differ" % (failed, len(golden | new)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print("usage: %s golden_dir new_dir" % sys.argv[0])
+        sys.exit(2)
+    sys.exit(main(sys.argv[1], sys.argv[2]))
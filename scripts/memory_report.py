@@ -0,0 +1,182 @@
+# Memory budget of the AVR build, printed after every link.
+#
+# Static RAM comes from the section sizes of the ELF. Worst-case stack
+# comes from the frame sizes gcc writes with -fstack-usage (.su files)
+# and the call graph read back from the disassembly: the deepest path
+# from main(), plus the deepest interrupt handler on top of it, since
+# an interrupt can arrive at any point of that path. The build fails
+# when less than custom_stack_margin bytes would be left.
+#
+# Calls through pointers (GameView callbacks, virtual display and Print
+# methods, the button handler) cannot be followed in the disassembly;
+# they are assumed to reach the deepest function in INDIRECT_TARGETS, or
+# in INTERRUPT_INDIRECT_TARGETS below an interrupt handler. Recursion
+# is reported, as it has no bound.
+
+Import("env")
+
+import glob
+import os
+import re
+import subprocess
+
+INDIRECT_TARGETS = [
+    r"eraseCell", r"drawEntity", r"playSound", r"updateScore", r"joystickISR",
+    r"Adafruit_\w+::\w+", r"Print::write", r"HardwareSerial::\w+",
+]
+INTERRUPT_INDIRECT_TARGETS = [r"joystickISR"]  # halAttachButton()
+
+RETURN_ADDRESS = 2  # bytes a call pushes on a 32 KB part
+CLONE_SUFFIX = re.compile(r"\.(constprop|isra|part|cold|lto_priv)\.\d+")
+
+
+def function_key(name):
+    # "bool Cadence::due(uint16_t)" and "Cadence::due(unsigned int)" both become "Cadence::due"
+    name = CLONE_SUFFIX.sub("", name.strip())
+    depth = 0
+    for i, c in enumerate(name):
+        if c == "<":
+            depth += 1
+        elif c == ">":
+            depth -= 1
+        elif c == "(" and depth == 0 and not name[:i].endswith("operator"):
+            name = name[:i]
+            break
+    return name.split(" ")[-1]
+
+
+def read_frames(build_dir):
+    # Largest frame per function name; overloads share a name and take the bigger one
+    frames = {}
+    dynamic = set()
+    for path in glob.glob(os.path.join(build_dir, "**", "*.su"), recursive=True):
+        with open(path) as su:
+            for line in su:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) < 3:
+                    continue
+                key = function_key(fields[0].split(":", 3)[-1])
+                frames[key] = max(frames.get(key, 0), int(fields[1]))
+                if "dynamic" in fields[2]:
+                    dynamic.add(key)
+    return frames, dynamic
+
+
+def read_calls(objdump, elf):
+    # Function -> functions it calls or jumps into, and the ones calling through a pointer
+    calls = {}
+    indirect = set()
+    current = None
+    header = re.compile(r"^[0-9a-f]+ <(.+)>:$")
+    branch = re.compile(r"\t(r?call|r?jmp)\t.*; 0x[0-9a-f]+ <([^>+]+)(\+0x[0-9a-f]+)?>")
+    listing = subprocess.check_output([objdump, "-d", "-C", elf], universal_newlines=True)
+    for line in listing.splitlines():
+        match = header.match(line)
+        if match:
+            current = function_key(match.group(1))
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        if "\ticall" in line or "\teicall" in line:
+            indirect.add(current)
+            continue
+        match = branch.search(line)
+        if match and not match.group(3):
+            target = function_key(match.group(2))
+            if target != current:
+                calls[current].add(target)
+    return calls, indirect
+
+
+def deepest(calls, frames, indirect, roots_pattern, indirect_targets):
+    targets = [f for f in calls if any(re.fullmatch(p, f) for p in indirect_targets)]
+    memo = {}
+    recursive = set()
+
+    def visit(function, path):
+        if function in memo:
+            return memo[function]
+        if function in path:
+            recursive.add(function)
+            return (0, [])
+        path.add(function)
+        callees = set(calls.get(function, ()))
+        if function in indirect:
+            callees.update(targets)
+        best = (0, [])
+        for callee in callees:
+            depth, chain = visit(callee, path)
+            if depth + RETURN_ADDRESS > best[0]:
+                best = (depth + RETURN_ADDRESS, chain)
+        path.discard(function)
+        memo[function] = (frames.get(function, 0) + best[0], [function] + best[1])
+        return memo[function]
+
+    results = [(visit(f, set()), f) for f in calls if re.fullmatch(roots_pattern, f)]
+    return (max(results) if results else ((0, []), None)), recursive
+
+
+def section_sizes(size_tool, elf):
+    sizes = {}
+    for line in subprocess.check_output([size_tool, "-A", elf], universal_newlines=True).splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith("."):
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def largest_variables(nm, elf, count):
+    variables = []
+    for line in subprocess.check_output([nm, "-C", "-S", "--size-sort", elf], universal_newlines=True).splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "bBdD":
+            variables.append((int(fields[1], 16), fields[3]))
+    return sorted(variables, reverse=True)[:count]
+
+
+def report(target, source, env):
+    elf = str(target[0])
+    build_dir = env.subst("$BUILD_DIR")
+    tools = env.subst("$OBJCOPY").replace("objcopy", "%s")
+    ram = int(env.BoardConfig().get("upload.maximum_ram_size", 2048))
+    margin = int(env.GetProjectOption("custom_stack_margin", "64"))
+
+    sizes = section_sizes(tools % "size", elf)
+    static = sizes.get(".data", 0) + sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+
+    frames, dynamic = read_frames(build_dir)
+    calls, indirect = read_calls(tools % "objdump", elf)
+    ((main_depth, main_chain), _), recursive = deepest(calls, frames, indirect, r"main", INDIRECT_TARGETS)
+    ((isr_depth, isr_chain), isr), isr_recursive = deepest(calls, frames, indirect, r"__vector_\d+", INTERRUPT_INDIRECT_TARGETS)
+    recursive |= isr_recursive
+    if isr:
+        isr_depth += RETURN_ADDRESS  # the interrupted code's return address
+
+    stack = main_depth + isr_depth
+    left = ram - static - stack
+
+    print("")
+    print("Memory budget, %d bytes of SRAM" % ram)
+    print("  static %5d  .data %d, .bss %d, .noinit %d" % (static, sizes.get(".data", 0), sizes.get(".bss", 0), sizes.get(".noinit", 0)))
+    for size, name in largest_variables(tools % "nm", elf, 8):
+        print("         %5d  %s" % (size, name))
+    print("  stack  %5d  main %d: %s" % (stack, main_depth, " > ".join(main_chain)))
+    print("                interrupt %d: %s" % (isr_depth, " > ".join(isr_chain)))
+    print("  left   %5d  (custom_stack_margin = %d)" % (left, margin))
+    unknown = sorted(f for f in set(main_chain + isr_chain) if f not in frames)
+    if unknown:
+        print("  no frame size for %s, counted as 0" % ", ".join(unknown))
+    if dynamic & set(main_chain + isr_chain):
+        print("  dynamic frames (alloca or variable arrays) in %s" % ", ".join(sorted(dynamic & set(main_chain + isr_chain))))
+    if recursive:
+        print("  recursion through %s is not bounded" % ", ".join(sorted(recursive)))
+    print("")
+
+    if left < margin:
+        print("Error: worst-case stack leaves %d bytes, under the %d byte margin" % (left, margin))
+        return 1
+    return 0
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)
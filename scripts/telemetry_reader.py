@@ -0,0 +1,212 @@
+# Host side of the serial telemetry, see include/telemetry.h. Reads the
+# frames from the board's serial port, or from the file the native build
+# writes them to ($SNAKE_TELEMETRY), rebuilds the board move by move and
+# prints it. Text diagnostics between the frames go to stderr. Commands
+# given with -c are sent to the board first, 100 ms apart.
+#
+#   python3 scripts/telemetry_reader.py /dev/ttyUSB0 -e 1 -c b
+#   SNAKE_TELEMETRY=game.bin .pio/build/native/program < input.txt
+#   python3 scripts/telemetry_reader.py game.bin
+#
+# A harness can drive a game the same way: Link(path) opens the port,
+# steer(), press() and resync() send commands, and frames() yields each
+# checked frame while a Board keeps track of the cells.
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import time
+import tty
+
+SYNC = 0x7E
+BAUD = termios.B500000
+
+FRAME_BEGIN, FRAME_TICK, FRAME_SNAPSHOT = 1, 2, 3
+FRAME_STEER, FRAME_BUTTON, FRAME_RESYNC = 0x10, 0x11, 0x12
+
+OP_ERASE, OP_DRAW, OP_SCORE = 0x00, 0x10, 0x20
+
+# Sprite + 1 of a cell, as in a snapshot
+SYMBOLS = ".o*x#"  # empty, snake, food, bad food, barrier
+MODES = ("game", "replay", "demo")
+
+
+def crc16(data):
+    # CRC-16/CCITT from 0xFFFF, as include/crc16.h
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(kind, payload=b""):
+    body = bytes((kind, 0, len(payload))) + payload
+    return bytes((SYNC,)) + body + struct.pack("<H", crc16(body))
+
+
+class Board:
+    def __init__(self):
+        self.cols = self.rows = 0
+        self.cells = []
+        self.seed = self.mode = None
+        self.points = self.level = 0
+        self.tick = 0
+        self.sequence = None
+        self.stale = True       # a frame went missing, wait for a snapshot
+        self.gaps = 0
+        self.disagreements = 0  # snapshot cells that differed from a board believed current
+
+    def apply(self, kind, sequence, payload):
+        if self.sequence is not None and sequence != (self.sequence + 1) & 0xFF:
+            self.gaps += 1
+            self.stale = True
+        self.sequence = sequence
+
+        if kind == FRAME_BEGIN:
+            self.cols, self.rows = payload[0], payload[1]
+            self.seed, mode = struct.unpack_from("<IB", payload, 2)
+            self.mode = MODES[mode] if mode < len(MODES) else mode
+            self.cells = [0] * (self.cols * self.rows)
+            self.points = self.level = self.tick = 0
+            self.stale = False
+        elif kind == FRAME_TICK:
+            self.tick = struct.unpack_from("<H", payload)[0]
+            i = 2
+            while i < len(payload):
+                op = payload[i]
+                if op == OP_SCORE:
+                    self.points, self.level = struct.unpack_from("<HB", payload, i + 1)
+                    i += 4
+                    continue
+                col, row = payload[i + 1], payload[i + 2]
+                if col < self.cols and row < self.rows:
+                    self.cells[row * self.cols + col] = 0 if op == OP_ERASE else op - OP_DRAW + 1
+                i += 3
+        elif kind == FRAME_SNAPSHOT:
+            first, cols, rows = struct.unpack_from("<HBB", payload)
+            if (cols, rows) != (self.cols, self.rows):
+                self.cols, self.rows = cols, rows  # joined during a game
+                self.cells = [0] * (cols * rows)
+                self.stale = True
+            for n, byte in enumerate(payload[4:]):
+                for half, code in enumerate((byte & 15, byte >> 4)):
+                    index = first + 2 * n + half
+                    if index < len(self.cells):
+                        if not self.stale and self.cells[index] != code:
+                            self.disagreements += 1
+                        self.cells[index] = code
+            if first + 2 * (len(payload) - 4) >= len(self.cells):
+                self.stale = False  # the last chunk, the board is whole again
+
+    def show(self, out):
+        out.write("tick %d  score %d  level %d%s\n" % (self.tick, self.points, self.level, "  (stale)" if self.stale else ""))
+        for row in range(self.rows):
+            line = self.cells[row * self.cols:(row + 1) * self.cols]
+            out.write("".join(SYMBOLS[code] if code < len(SYMBOLS) else "?" for code in line) + "\n")
+
+
+class Link:
+    def __init__(self, path):
+        self.serial = not os.path.isfile(path)
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY if self.serial else os.O_RDONLY)
+        if self.serial:
+            tty.setraw(self.fd)
+            attributes = termios.tcgetattr(self.fd)
+            attributes[4] = attributes[5] = BAUD
+            termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        self.buffer = bytearray()
+        self.text = bytearray()
+
+    def send(self, frame):
+        if self.serial:
+            os.write(self.fd, frame)
+
+    def steer(self, direction):
+        self.send(encode(FRAME_STEER, direction.encode()))
+
+    def press(self):
+        self.send(encode(FRAME_BUTTON))
+
+    def resync(self):
+        self.send(encode(FRAME_RESYNC))
+
+    def frames(self):
+        # (type, sequence, payload) of every frame whose CRC checks out, until the end of a file
+        while True:
+            chunk = os.read(self.fd, 4096)
+            if not chunk:
+                if self.serial:
+                    continue
+                return
+            self.buffer += chunk
+            while True:
+                frame = self._next()
+                if frame is None:
+                    break
+                yield frame
+
+    def _next(self):
+        while self.buffer:
+            if self.buffer[0] != SYNC:
+                self._text(self.buffer.pop(0))
+                continue
+            if len(self.buffer) < 4 or len(self.buffer) < 6 + self.buffer[3]:
+                return None
+            length = self.buffer[3]
+            body = bytes(self.buffer[1:4 + length])
+            if struct.unpack_from("<H", self.buffer, 4 + length)[0] == crc16(body):
+                del self.buffer[:6 + length]
+                return body[0], body[1], body[3:]
+            self._text(self.buffer.pop(0))  # a sync byte in the text, or a damaged frame
+        return None
+
+    def _text(self, byte):
+        if byte == ord("\n"):
+            sys.stderr.write(self.text.decode("ascii", "replace") + "\n")
+            self.text = bytearray()
+        else:
+            self.text.append(byte)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Rebuild the board from the serial telemetry")
+    parser.add_argument("source", help="serial device, or a file of frames")
+    parser.add_argument("-e", "--every", type=int, default=0, help="print the board every N moves, 0 for only at the end of each game")
+    parser.add_argument("-c", "--commands", default="", help="u d l r steer, b presses the button, k asks for a snapshot")
+    args = parser.parse_args()
+
+    link = Link(args.source)
+    for command in args.commands:
+        if command in "udlr":
+            link.steer(command)
+        elif command == "b":
+            link.press()
+        elif command == "k":
+            link.resync()
+        time.sleep(0.1)
+
+    board = Board()
+    printed = False
+    for kind, sequence, payload in link.frames():
+        if kind == FRAME_BEGIN and board.cells and not printed:
+            board.show(sys.stdout)  # the game before this one
+        board.apply(kind, sequence, payload)
+        printed = False
+        if kind == FRAME_BEGIN:
+            print("game %s, seed %d, %d x %d" % (board.mode, board.seed, board.cols, board.rows))
+        elif kind == FRAME_TICK and args.every and board.tick % args.every == 0:
+            board.show(sys.stdout)
+            printed = True
+    if board.cells and not printed:
+        board.show(sys.stdout)
+    print("%d gaps, %d cells disagreed with a snapshot" % (board.gaps, board.disagreements))
+    return 1 if board.disagreements else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
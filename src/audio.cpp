@@ -0,0 +1,102 @@
+#include "audio.h"
+#include "hal.h"
+#include "profiler.h"
+
+//=================================================================
+// Melodies. A frequency of 0 is a rest.
+
+struct Note {
+  uint16_t frequency;  // Hz
+  uint16_t duration;   // ms
+};
+
+const Note foodEatenNotes[] PROGMEM = { {523, 50}, {784, 200} };
+const Note badFoodShownNotes[] PROGMEM = { {10, 100} };
+const Note gameStartNotes[] PROGMEM = {
+  {900, 50}, {0, 50}, {800, 50}, {0, 50}, {700, 50}, {0, 50},
+  {600, 50}, {0, 50}, {500, 50}, {0, 50}, {400, 50}, {0, 50},
+  {300, 50}, {0, 50}, {200, 50}, {0, 50}, {100, 50}, {0, 50}
+};
+const Note gameOverNotes[] PROGMEM = { {523, 50}, {392, 50}, {330, 50}, {293, 50}, {262, 400} };
+const Note badFoodEatenNotes[] PROGMEM = { {6000, 400} };
+const Note pauseNotes[] PROGMEM = { {9000, 10} };
+const Note resumeNotes[] PROGMEM = { {10000, 10} };
+const Note clickNotes[] PROGMEM = { {1000, 10} };
+
+struct Melody {
+  const Note *notes;
+  uint8_t length;
+};
+
+#define MELODY(notes) { notes, sizeof(notes) / sizeof(Note) }
+
+// Indexed by SoundId
+const Melody melodies[SOUND_COUNT] PROGMEM = {
+  MELODY(foodEatenNotes),
+  MELODY(badFoodShownNotes),
+  MELODY(gameStartNotes),
+  MELODY(gameOverNotes),
+  MELODY(badFoodEatenNotes),
+  MELODY(pauseNotes),
+  MELODY(resumeNotes),
+  MELODY(clickNotes),
+};
+
+//=================================================================
+// Sequencer state, shared with the timer interrupt
+
+static volatile uint8_t queue[SOUND_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0;   // next sound to play
+static volatile uint8_t queueCount = 0;
+
+static const Note *volatile currentNote = 0;  // note playing, 0 when idle
+static volatile uint8_t notesLeft = 0;        // notes after currentNote
+static volatile uint16_t msLeft = 0;          // time left on currentNote
+
+static void startNote(const Note *note) {
+  uint16_t frequency = pgm_read_word(&note->frequency);
+  halTone(frequency);
+  currentNote = note;
+  msLeft = pgm_read_word(&note->duration);
+}
+
+// Called with interrupts off: move on to the next note or the next queued sound
+static void advance() {
+  if (currentNote && notesLeft) {
+    notesLeft--;
+    startNote(currentNote + 1);
+    return;
+  }
+  if (queueCount) {
+    Melody melody;
+    memcpy_P(&melody, &melodies[queue[queueHead]], sizeof(Melody));
+    queueHead = (queueHead + 1) % SOUND_QUEUE_SIZE;
+    queueCount--;
+    notesLeft = melody.length - 1;
+    startNote(melody.notes);
+    return;
+  }
+  currentNote = 0;
+  halTone(0);
+}
+
+void audioTick() {
+  if (!currentNote) return;
+  PROFILE(PROBE_AUDIO);
+  if (msLeft == 0 || --msLeft == 0) advance();
+}
+
+void playSound(SoundId sound) {
+  if (sound >= SOUND_COUNT) return;
+  uint8_t state = halLock();
+  if (queueCount < SOUND_QUEUE_SIZE) {
+    queue[(queueHead + queueCount) % SOUND_QUEUE_SIZE] = sound;
+    queueCount++;
+    if (!currentNote) advance();  // idle: start right away instead of on the next tick
+  }
+  halUnlock(state);
+}
+
+bool audioBusy() {
+  return currentNote != 0 || queueCount != 0;
+}
@@ -0,0 +1,150 @@
+#include "autopilot.h"
+#include "profiler.h"
+
+#define UNREACHED 3
+
+static const char directions[4] = { 'r', 'l', 'u', 'd' };
+
+static uint8_t distanceAt(const Autopilot &pilot, uint16_t index) {
+  return (pilot.distance[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+static void setDistance(Autopilot &pilot, uint16_t index, uint8_t value) {
+  uint8_t shift = (index & 3) * 2;
+  uint8_t &slot = pilot.distance[index >> 2];
+  slot = (slot & ~(3 << shift)) | (value << shift);
+}
+
+// Nothing in the way: the snake may move into the cell this move
+static bool freeCell(const Game &game, Cell cell) {
+  return !game.bodyGrid.test(cell) && !game.barrierGrid.test(cell) && !game.badFoodGrid.test(cell);
+}
+
+static char opposite(char direction) {
+  return direction == 'r' ? 'l' : direction == 'l' ? 'r' : direction == 'u' ? 'd' : 'u';
+}
+
+static void restart(Autopilot &pilot, const Game &game) {
+  for (IndexFor<sizeof(Autopilot::distance)> i = 0; i < sizeof(pilot.distance); i++) pilot.distance[i] = 0xFF;  // all UNREACHED
+  pilot.frontier.clear();
+  pilot.target = game.food;
+  setDistance(pilot, game.food.index(), 0);
+  pilot.frontier.set(game.food);
+  pilot.wave = 0;
+  pilot.cursor = 0;
+  pilot.grew = false;
+  pilot.ready = false;
+  pilot.followed = 0;
+}
+
+void autopilotBegin(Autopilot &pilot, uint8_t snake) {
+  // An impossible target, so the first look at a game starts a search
+  pilot.snake = snake;
+  pilot.target.col = GRID_COLS;
+  pilot.target.row = GRID_ROWS;
+  pilot.ready = false;
+}
+
+// Reach the free neighbours of a cell one step further from the food.
+// The head counts as free, the search has to arrive there.
+static void expand(Autopilot &pilot, const Game &game, Cell cell) {
+  uint8_t next = pilot.wave == 2 ? 0 : pilot.wave + 1;
+  for (uint8_t i = 0; i < 4; i++) {
+    Cell neighbour = cell;
+    stepCell(neighbour, directions[i]);
+    uint16_t index = neighbour.index();
+    if (distanceAt(pilot, index) != UNREACHED) continue;
+    if (!freeCell(game, neighbour) && neighbour != game.snakes.head[pilot.snake]) continue;
+    setDistance(pilot, index, next);
+    pilot.frontier.set(neighbour);
+    pilot.grew = true;
+  }
+}
+
+void autopilotThink(Autopilot &pilot, const Game &game, uint16_t budget) {
+  // CONTINUE THE SEARCH WHERE THE LAST MOVE LEFT IT
+  PROFILE(PROBE_AUTOPILOT);
+  if (game.food != pilot.target) restart(pilot, game);
+
+  while (!pilot.ready && budget > 0) {
+    if (distanceAt(pilot, game.snakes.head[pilot.snake].index()) != UNREACHED) {
+      pilot.ready = true;
+      break;
+    }
+
+    if (pilot.cursor == sizeof(pilot.frontier.bits)) {
+      // One wave done; without new cells the head cannot be reached right
+      // now, start over as the body moving on may open a way
+      if (!pilot.grew) {
+        restart(pilot, game);
+        break;
+      }
+      pilot.wave = pilot.wave == 2 ? 0 : pilot.wave + 1;
+      pilot.cursor = 0;
+      pilot.grew = false;
+      continue;
+    }
+
+    // Expand this wave's cells in the byte, the next wave's stay for later
+    uint8_t pending = pilot.frontier.bits[pilot.cursor];
+    while (pending && budget > 0) {
+      uint8_t bit = __builtin_ctz(pending);
+      pending &= pending - 1;
+      uint16_t index = pilot.cursor * 8 + bit;
+      if (distanceAt(pilot, index) != pilot.wave) continue;
+      pilot.frontier.bits[pilot.cursor] &= ~(1 << bit);
+      expand(pilot, game, cellAt(index));
+      budget--;
+    }
+    if (!pending) pilot.cursor++;
+  }
+}
+
+// Free cells next to a cell, how much room a move there leaves
+static uint8_t room(const Game &game, Cell cell) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    Cell neighbour = cell;
+    stepCell(neighbour, directions[i]);
+    if (freeCell(game, neighbour)) count++;
+  }
+  return count;
+}
+
+char autopilotSteer(Autopilot &pilot, const Game &game) {
+  // FOLLOW THE FIELD DOWNHILL, OR FIND ROOM WHEN THERE IS NONE
+  const Cell &head = game.snakes.head[pilot.snake];
+  char heading = game.snakes.direction[pilot.snake];
+  uint8_t here = distanceAt(pilot, head.index());
+  if (pilot.ready && pilot.target == game.food && here != UNREACHED && ++pilot.followed < GRID_CELLS) {
+    uint8_t closer = (here + 2) % 3;
+    for (uint8_t i = 0; i < 4; i++) {
+      if (directions[i] == opposite(heading)) continue;
+      Cell next = head;
+      stepCell(next, directions[i]);
+      if (distanceAt(pilot, next.index()) == closer && freeCell(game, next)) {
+        return directions[i] == heading ? 0 : directions[i];
+      }
+    }
+  }
+
+  // The way ahead is blocked or was never found: search again from scratch
+  if (pilot.ready) restart(pilot, game);
+
+  // Straight ahead wins a tie, turning costs nothing but looks nervous
+  char best = 0;
+  uint8_t bestRoom = 0;
+  for (uint8_t i = 0; i < 5; i++) {
+    char direction = i == 0 ? heading : directions[i - 1];
+    if (i > 0 && (direction == heading || direction == opposite(heading))) continue;
+    Cell next = head;
+    stepCell(next, direction);
+    if (!freeCell(game, next)) continue;
+    uint8_t space = room(game, next) + 1;
+    if (space > bestRoom) {
+      bestRoom = space;
+      best = direction;
+    }
+  }
+  return best == heading ? 0 : best;
+}
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "sim.h"
+#include "autopilot.h"
+
+//=================================================================
+// Tick throughput of the game rules on the host. Each scenario drives
+// the headless simulator for a fixed number of moves and reports moves
+// per second, time per move and heap allocations during the run. The
+// checksum only changes when the rules do, so a faster build that
+// prints a different checksum is simulating a different game. The crowd
+// scenario fills the board with MAX_SNAKES snakes (16 in the bench build)
+// all chasing the same food, for the cost of a move with many actors.
+// Hand-laid meetings of two snakes then check how crowd collisions end,
+// and the exit status says whether they all did.
+//
+// Replays saved from the device ('g' on its serial port) can follow on
+// the command line. Each is played back as fast as the rules run and
+// checked against the move count and score it was recorded with.
+//
+//   pio run -e bench && .pio/build/bench/program [ticks per scenario] [replay file...]
+
+#define DEFAULT_TICKS 2000000UL
+#define BENCH_SEED 1
+#define LONG_SNAKE (MAX_SNAKE_LENGTH - 75)  // leaves room for food and hazards
+#define REPLAY_TICK_LIMIT 10000000UL  // for replays cut short, which never say when they end
+
+//=================================================================
+// Heap allocations, counted by wrapping malloc at link time
+// (-Wl,--wrap=malloc and friends in the bench environment)
+
+static unsigned long allocations = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+  allocations++;
+  return __real_realloc(pointer, size);
+}
+}
+
+//=================================================================
+// Pilots: what the player does in each scenario
+
+struct Pilot {
+  SimScript script;
+  uint32_t phase;  // moves into the helix
+  Autopilot autopilot;
+};
+
+static char followScript(Sim &, Pilot &pilot) {
+  return pilot.script.next();
+}
+
+static char chaseFood(Sim &sim, Pilot &) {
+  return simChase(sim.game, 0);
+}
+
+// Every snake chases the same food; the rivals are steered here, snake 0 by the sim
+static char chaseInCrowd(Sim &sim, Pilot &) {
+  for (uint8_t s = 1; s < sim.game.snakes.count; s++) {
+    if (!sim.game.snakes.alive[s]) continue;
+    char turn = simChase(sim.game, s);
+    if (turn) gameSteer(sim.game, turn, s);
+  }
+  return simChase(sim.game, 0);
+}
+
+static char followAutopilot(Sim &sim, Pilot &pilot) {
+  autopilotThink(pilot.autopilot, sim.game, AUTOPILOT_BUDGET);
+  return autopilotSteer(pilot.autopilot, sim.game);
+}
+
+// Right along a row, then one down: every GRID_CELLS moves cover the
+// board once, so a snake shorter than the board never meets itself
+static char helixMove(uint32_t phase) {
+  return phase % GRID_COLS == GRID_COLS - 1 ? 'd' : 'r';
+}
+
+static char followHelix(Sim &, Pilot &pilot) {
+  return helixMove(pilot.phase++);
+}
+
+//=================================================================
+// Scenarios. setup() runs after every new game and is not timed.
+
+static void freshGame(Sim &, Pilot &pilot) {
+  pilot.script.position = 0;
+}
+
+static void freshAutopilot(Sim &, Pilot &pilot) {
+  autopilotBegin(pilot.autopilot);
+}
+
+static void longSnake(Sim &sim, Pilot &pilot) {
+  // Lay a snake of LONG_SNAKE segments along the helix
+  Game &game = sim.game;
+  game.bodyGrid.clear();
+  Cell start = { 0, 0 };
+  game.snakes.place(0, start, 'r');
+  game.bodyGrid.set(start);
+  for (pilot.phase = 0; pilot.phase < LONG_SNAKE - 1; pilot.phase++) {
+    game.snakes.pushHead(0, helixMove(pilot.phase));
+    game.bodyGrid.set(game.snakes.head[0]);
+  }
+  game.snakes.direction[0] = helixMove(pilot.phase);
+  if (game.bodyGrid.test(game.food)) gamePlaceFood(game);
+}
+
+static void lastLevel(Sim &sim, Pilot &) {
+  // One food short of the last level, so the next food brings the most bad food
+  Game &game = sim.game;
+  game.points[0] = 2 * (MAX_LEVEL - 1) - 1;
+  game.level = game.points[0] / 2 + 1;
+  loadLevel(game.level, game.levelParams);
+}
+
+struct Scenario {
+  const char *name;
+  uint8_t snakes;
+  void (*setup)(Sim &sim, Pilot &pilot);
+  char (*steer)(Sim &sim, Pilot &pilot);
+};
+
+static const Scenario scenarios[] = {
+  { "early game", 1, freshGame, followScript },
+  { "chase food", 1, freshGame, chaseFood },
+  { "max length", 1, longSnake, followHelix },
+  { "many bad food", 1, lastLevel, chaseFood },
+  { "autopilot", 1, freshAutopilot, followAutopilot },
+  { "crowd", MAX_SNAKES, freshGame, chaseInCrowd },
+};
+
+// Sweeps the whole board, so the food is reached without steering for it
+static const char sweep[] = "rrrrrrrrrrrrrrrrrrrrrrd";
+
+//=================================================================
+
+typedef std::chrono::steady_clock Clock;
+
+static void run(const Scenario &scenario, uint32_t ticks) {
+  static Sim sim;
+  static Pilot pilot;
+  pilot.script.moves = sweep;
+  pilot.script.length = sizeof(sweep) - 1;
+  pilot.script.position = 0;
+  pilot.phase = 0;
+
+  simBegin(sim, BENCH_SEED, scenario.snakes);
+  scenario.setup(sim, pilot);
+
+  // Only the moves are timed, starting over after a game ends is not
+  Clock::duration elapsed = Clock::duration::zero();
+  allocations = 0;
+  Clock::time_point start = Clock::now();
+  while (sim.stats.ticks < ticks) {
+    if (!simTick(sim, scenario.steer(sim, pilot))) {
+      elapsed += Clock::now() - start;
+      simNewGame(sim);
+      scenario.setup(sim, pilot);
+      start = Clock::now();
+    }
+  }
+  elapsed += Clock::now() - start;
+
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  const SimStats &stats = sim.stats;
+  printf("%-14s %10lu %11.0f %8.1f %7lu %7lu %6u %6u  %08lx\n",
+         scenario.name, (unsigned long)stats.ticks, stats.ticks / ns * 1e9, ns / stats.ticks,
+         allocations, (unsigned long)stats.games, stats.bestScore, stats.maxLength,
+         (unsigned long)stats.checksum);
+}
+
+//=================================================================
+// Crowd checks. Two snakes are laid by hand, each a straight line from
+// its tail towards its heading, and make one move; each must crash the
+// way the rules say.
+
+struct Meeting {
+  const char *name;
+  Cell tail[2];
+  char heading[2];
+  uint8_t length[2];
+  Crash crash[2];
+};
+
+static const Meeting meetings[] = {
+  { "same cell", { { 4, 5 }, { 6, 5 } }, { 'r', 'l' }, { 1, 1 }, { CRASH_HEAD_ON, CRASH_HEAD_ON } },
+  { "swap", { { 5, 5 }, { 6, 5 } }, { 'r', 'l' }, { 1, 1 }, { CRASH_HEAD_ON, CRASH_HEAD_ON } },
+  { "swap, one long", { { 5, 5 }, { 8, 5 } }, { 'r', 'l' }, { 1, 3 }, { CRASH_BODY, CRASH_HEAD_ON } },
+  { "swap down", { { 5, 5 }, { 5, 6 } }, { 'd', 'u' }, { 1, 1 }, { CRASH_HEAD_ON, CRASH_HEAD_ON } },
+  { "swap at the wall", { { 0, 5 }, { GRID_COLS - 1, 5 } }, { 'l', 'r' }, { 1, 1 }, { CRASH_HEAD_ON, CRASH_HEAD_ON } },
+  { "passing", { { 5, 5 }, { 6, 6 } }, { 'r', 'l' }, { 1, 1 }, { CRASH_NONE, CRASH_NONE } },
+};
+
+static bool crowdChecks() {
+  static Sim sim;
+  bool ok = true;
+  for (uint8_t i = 0; i < sizeof(meetings) / sizeof(meetings[0]); i++) {
+    const Meeting &meeting = meetings[i];
+    simBegin(sim, BENCH_SEED, 2);
+    Game &game = sim.game;
+    game.bodyGrid.clear();
+    game.barrierGrid.clear();
+    game.badFoodGrid.clear();
+    game.food.col = 1;
+    game.food.row = GRID_ROWS - 1;  // away from row 5
+    for (uint8_t s = 0; s < 2; s++) {
+      game.snakes.place(s, meeting.tail[s], meeting.heading[s]);
+      game.bodyGrid.set(meeting.tail[s]);
+      for (uint8_t n = 1; n < meeting.length[s]; n++) {
+        game.snakes.pushHead(s, meeting.heading[s]);
+        game.bodyGrid.set(game.snakes.head[s]);
+      }
+    }
+    gameStep(game);
+    bool matched = game.crash[0] == meeting.crash[0] && game.crash[1] == meeting.crash[1];
+    if (!matched) {
+      printf("crowd check %s: crashes %u %u, expected %u %u\n", meeting.name,
+             game.crash[0], game.crash[1], meeting.crash[0], meeting.crash[1]);
+    }
+    ok = matched && ok;
+  }
+  return ok;
+}
+
+//=================================================================
+// Replays
+
+static int hexDigit(int c) {
+  return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static uint16_t readReplay(const char *path, uint8_t *bytes) {
+  // A line as the device sends it, "replay " and then the bytes in hex
+  FILE *file = fopen(path, "r");
+  if (!file) return 0;
+  char prefix[8];
+  uint16_t length = 0;
+  if (fscanf(file, "%7s ", prefix) == 1 && strcmp(prefix, "replay") == 0) {
+    int high, low;
+    while (length < REPLAY_CAPACITY && (high = hexDigit(fgetc(file))) >= 0 && (low = hexDigit(fgetc(file))) >= 0) {
+      bytes[length++] = high << 4 | low;
+    }
+  }
+  fclose(file);
+  return length;
+}
+
+static bool verify(const char *path) {
+  static Sim sim;
+  uint8_t bytes[REPLAY_CAPACITY];
+  ReplayReader reader;
+  if (!replayOpen(reader, bytes, readReplay(path, bytes))) {
+    printf("%-14s not a replay\n", path);
+    return false;
+  }
+
+  simBegin(sim, reader.seed);
+  sim.stats.games = 0;
+  Clock::time_point start = Clock::now();
+  bool matched = simReplay(sim, reader, REPLAY_TICK_LIMIT);
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  const SimStats &stats = sim.stats;
+  printf("%-14s %10lu %11.0f %8.1f %7s %7lu %6u %6u  %s\n",
+         path, (unsigned long)stats.ticks, stats.ticks / ns * 1e9, ns / stats.ticks, "-",
+         (unsigned long)stats.games, sim.game.points[0], sim.game.snakes.length[0],
+         matched ? "ok" : reader.verified ? "MISMATCH" : "unchecked");
+  return matched || !reader.verified;
+}
+
+int main(int argc, char **argv) {
+  uint32_t ticks = argc > 1 ? strtoul(argv[1], 0, 0) : DEFAULT_TICKS;
+  if (ticks == 0) {
+    fprintf(stderr, "usage: %s [ticks per scenario] [replay file...]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-14s %10s %11s %8s %7s %7s %6s %6s  %s\n",
+         "scenario", "ticks", "ticks/s", "ns/tick", "allocs", "games", "best", "length", "checksum");
+  for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) run(scenarios[i], ticks);
+
+  bool ok = crowdChecks();
+  for (int i = 2; i < argc; i++) ok = verify(argv[i]) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+#include "engine.h"
+#include "spawn.h"
+#include "profiler.h"
+
+// Barriers placed while the head is near the centre go to a corner
+// instead: a 5x5 block around the middle cell, and corners of 4 cells
+// across, 3 high at the top and 4 high at the bottom
+#define CENTRE_COL (GRID_COLS / 2)
+#define CENTRE_ROW (GRID_ROWS / 2)
+#define CORNER_LEFT 0
+#define CORNER_RIGHT (GRID_COLS - 4)
+#define CORNER_BOTTOM (GRID_ROWS - 6)
+
+static char opposite(char direction) {
+  switch (direction) {
+    case 'r': return 'l';
+    case 'l': return 'r';
+    case 'u': return 'd';
+    default:  return 'u';
+  }
+}
+
+static void scheduleFoodExpiry(Game &game) {
+  // The food lives as long as the current level says, so a level change moves its deadline
+  if (game.levelParams.foodLifetime) game.timers.schedule(TIMER_FOOD, game.foodSpawnTime + game.levelParams.foodLifetime);
+  else game.timers.cancel(TIMER_FOOD);
+}
+
+static void changeLevel(Game &game) {
+  // The level follows the leading snake
+  unsigned short best = 0;
+  for (uint8_t s = 0; s < game.snakes.count; s++) {
+    if (game.points[s] > best) best = game.points[s];
+  }
+  game.level = best / 2 + 1;
+  loadLevel(game.level, game.levelParams);
+  scheduleFoodExpiry(game);
+  game.view->score(game.points[0], game.level);
+}
+
+void gamePlaceFood(Game &game) {
+  // Food goes on any cell not taken by the snake, the barrier or bad food
+  OccupancyGrid blocked = game.bodyGrid;
+  blocked.merge(game.barrierGrid);
+  blocked.merge(game.badFoodGrid);
+  placeInFreeCell(blocked, game.foodRng, game.food);
+  game.view->draw(game.food, SPRITE_FOOD);
+  game.foodSpawnTime = game.clock;
+  scheduleFoodExpiry(game);
+}
+
+static void placeBarrier(Game &game, Cell head, Cell &barrier) {
+  // Barrier must not overlap with the snake's body, bad food or the other barriers
+  OccupancyGrid blocked = game.bodyGrid;
+  blocked.merge(game.badFoodGrid);
+  blocked.merge(game.barrierGrid);
+
+  // Ensuring there is a comfortable space between the food and the barrier
+  for (int col = game.food.col - 3; col <= game.food.col + 3; col++) {
+    for (int row = game.food.row - 3; row <= game.food.row + 3; row++) {
+      if (col < 0 || col >= GRID_COLS || row < 0 || row >= GRID_ROWS) continue;
+      Cell near = { (uint8_t)col, (uint8_t)row };
+      blocked.set(near);
+    }
+  }
+
+  if (((head.col >= CENTRE_COL - 2) && (head.col <= CENTRE_COL + 2)) && ((head.row >= CENTRE_ROW - 2) && (head.row <= CENTRE_ROW + 2))){
+    // placing the barrier at a random corner if the snake eats food near the center of the screen
+    uint8_t corner = game.barrierRng.below(4);
+    Cell cell;
+    cell.col = ((corner & 1) ? CORNER_RIGHT : CORNER_LEFT) + game.barrierRng.below(4);
+    cell.row = (corner & 2) ? CORNER_BOTTOM + game.barrierRng.below(4) : game.barrierRng.below(3);
+    if (!blocked.test(cell)) {
+      barrier = cell;
+      return;
+    }
+  }
+  placeInFreeCell(blocked, game.barrierRng, barrier);
+}
+
+static void eatFood(Game &game, uint8_t snake) {
+  // SCORE, THEN RESHUFFLE FOOD, BARRIERS AND BAD FOOD FOR THE NEW LEVEL
+  PROFILE(PROBE_SPAWN);
+  game.view->sound(SOUND_FOOD_EATEN);
+  game.points[snake]++;
+  changeLevel(game);
+  // The snake has already grown: its tail stayed put on this move
+
+  // The head already covers the old food, generate new food
+  gamePlaceFood(game);
+
+  game.barrierGrid.clear();
+  for (uint8_t i = 0; i < game.barrierCount; i++) {
+    game.view->erase(game.barriers[i]);
+  }
+
+  for (uint8_t i = 0; i < game.badFoodCount; i++) {
+    if (!game.bodyGrid.test(game.badFood[i])) game.view->erase(game.badFood[i]);
+  }
+  game.badFoodGrid.clear();
+
+  // Barriers appear from level 2
+  game.barrierCount = game.levelParams.barrierCount;
+  for (uint8_t i = 0; i < game.barrierCount; i++) {
+    placeBarrier(game, game.snakes.head[snake], game.barriers[i]);
+    game.barrierGrid.set(game.barriers[i]);
+    game.view->draw(game.barriers[i], SPRITE_BARRIER);
+  }
+
+  // Bad food appears from level 4
+  game.badFoodCount = game.levelParams.badFoodCount;
+  if (game.badFoodCount > 0) {
+    // Bad food stays off the snake, the barrier, the food and each other
+    OccupancyGrid blocked = game.bodyGrid;
+    blocked.merge(game.barrierGrid);
+    blocked.set(game.food);
+    for (uint8_t i = 0; i < game.badFoodCount; i++){
+      // Placing bad food once the food has been eaten
+      placeInFreeCell(blocked, game.hazardRng, game.badFood[i]);
+      blocked.set(game.badFood[i]);
+      game.badFoodGrid.set(game.badFood[i]);
+      game.view->draw(game.badFood[i], SPRITE_BAD_FOOD);
+      game.view->sound(SOUND_BAD_FOOD_SHOWN);
+    }
+  }
+}
+
+static void expireFood(Game &game) {
+  // Timed food from level 3: once its lifetime is up it moves elsewhere
+  PROFILE(PROBE_SPAWN);
+  game.view->erase(game.food);  // Hide food
+  game.foodMissed++;
+  gamePlaceFood(game);
+}
+
+void gameBegin(Game &game, uint32_t seed, const GameView *view, uint8_t snakes) {
+  // EVERY SPAWN OF A GAME IS REPRODUCIBLE FROM ITS SEED
+  game.view = view;
+  game.foodRng.seed(seed, RNG_STREAM_FOOD);
+  game.barrierRng.seed(seed, RNG_STREAM_BARRIER);
+  game.hazardRng.seed(seed, RNG_STREAM_HAZARD);
+  game.bodyGrid.clear();
+  game.barrierGrid.clear();
+  game.badFoodGrid.clear();
+  game.barrierCount = 0;
+  game.badFoodCount = 0;
+
+  // Initialize every snake with one segment, heading right
+  game.snakes.reset(snakes);
+  for (uint8_t s = 0; s < snakes; s++) {
+    Cell start;
+    placeInFreeCell(game.bodyGrid, game.foodRng, start);
+    game.snakes.place(s, start, 'r');
+    game.bodyGrid.set(start);
+    game.turnCount[s] = 0;
+    game.points[s] = 0;
+    game.crash[s] = CRASH_NONE;
+  }
+  game.over = false;
+  game.ticks = 0;
+  game.clock = 0;
+  game.timers.reset(game.clock);
+  game.foodMissed = 0;
+
+  game.level = 1;
+  loadLevel(game.level, game.levelParams);
+
+  gamePlaceFood(game);
+  for (uint8_t s = 0; s < snakes; s++) view->draw(game.snakes.head[s], SPRITE_SNAKE);
+}
+
+void gameSteer(Game &game, char direction, uint8_t snake) {
+  // Make the snake move without going in reverse direction; each turn is
+  // checked against the one before it, so the whole queue stays valid
+  uint8_t &count = game.turnCount[snake];
+  char *turns = game.turns[snake];
+  char heading = count ? turns[count - 1] : game.snakes.direction[snake];
+  if (direction == heading || direction == opposite(heading)) return;
+  if (count == TURN_QUEUE_SIZE) return;
+  turns[count++] = direction;
+}
+
+static void takeTurn(Game &game, uint8_t snake) {
+  uint8_t &count = game.turnCount[snake];
+  char *turns = game.turns[snake];
+  if (count == 0) return;
+  game.snakes.direction[snake] = turns[0];
+  count--;
+  for (uint8_t i = 0; i < count; i++) turns[i] = turns[i + 1];
+}
+
+// Snakes whose keys are the same cell have met. Every snake taking part
+// marks its key, one finding the mark already there clears it again, and
+// then every snake whose key is left unmarked has met another.
+static void meetings(const SnakeSet &snakes, const Cell *key, const bool *taking, Crash *crash) {
+  OccupancyGrid marks;
+  marks.clear();
+  bool later[MAX_SNAKES];
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (!taking[s]) continue;
+    later[s] = marks.test(key[s]);
+    marks.set(key[s]);
+  }
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (taking[s] && later[s]) marks.reset(key[s]);
+  }
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (taking[s] && !marks.test(key[s]) && !crash[s]) crash[s] = CRASH_HEAD_ON;
+  }
+}
+
+// Heads moving into the same cell crash into each other, and so do two
+// heads swapping cells: they pass on the edge between them, so snakes
+// meet on an edge as well as on a cell. Only snakes heading opposite
+// ways can share an edge, which is keyed by its left or top cell, with
+// the horizontal and the vertical edges looked at apart.
+static void headOnCollisions(const SnakeSet &snakes, const Cell *next, Crash *crash) {
+  bool taking[MAX_SNAKES];
+  Cell edge[MAX_SNAKES];
+  for (uint8_t s = 0; s < snakes.count; s++) taking[s] = snakes.alive[s];
+  meetings(snakes, next, taking, crash);
+
+  for (uint8_t vertical = 0; vertical < 2; vertical++) {
+    for (uint8_t s = 0; s < snakes.count; s++) {
+      char direction = snakes.direction[s];
+      taking[s] = snakes.alive[s] && (direction == 'u' || direction == 'd') == (bool)vertical;
+      edge[s] = direction == 'r' || direction == 'd' ? snakes.head[s] : next[s];
+    }
+    meetings(snakes, edge, taking, crash);
+  }
+}
+
+// A crashed snake leaves the board, tail first. A tail that left its cell
+// on this move is gone already, and another head may have taken the cell.
+static void removeSnake(Game &game, uint8_t snake, bool vacated) {
+  SnakeSet &snakes = game.snakes;
+  snakes.alive[snake] = false;
+  if (vacated) {
+    if (snakes.length[snake] == 1) return;
+    snakes.popTail(snake);
+  }
+  for (;;) {
+    game.bodyGrid.reset(snakes.tail[snake]);
+    game.view->erase(snakes.tail[snake]);
+    if (snakes.length[snake] == 1) return;
+    snakes.popTail(snake);
+  }
+}
+
+void gameStep(Game &game) {
+  PROFILE(PROBE_STEP);
+  SnakeSet &snakes = game.snakes;
+  game.ticks++;
+  game.clock += game.levelParams.tickPeriod;
+
+  // Work out where each head goes next and whether it reaches the food
+  Cell next[MAX_SNAKES];
+  bool growing[MAX_SNAKES];
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (!snakes.alive[s]) continue;
+    takeTurn(game, s);
+    next[s] = snakes.head[s];
+    stepCell(next[s], snakes.direction[s]);
+    growing[s] = next[s] == game.food && snakes.length[s] < snakes.capacity;
+
+    if (!growing[s]) {
+      // Clear the last segment of the snake
+      game.bodyGrid.reset(snakes.tail[s]);
+      game.view->erase(snakes.tail[s]);
+    }
+  }
+
+  // Every tail has already left its cell, so any body bit under a new head
+  // is a collision, with its own body or another snake's
+  uint8_t standing = 0;
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (!snakes.alive[s]) continue;
+    if (game.bodyGrid.test(next[s])) game.crash[s] = CRASH_BODY;
+    else if (game.barrierGrid.test(next[s])) game.crash[s] = CRASH_BARRIER;
+  }
+  if (snakes.count > 1) headOnCollisions(snakes, next, game.crash);
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (snakes.alive[s] && !game.crash[s]) standing++;
+  }
+  game.over = standing == 0 || (snakes.count > 1 && standing == 1);
+
+  // Move the heads and let the tails follow unless the snake grows. The
+  // move that ends the game is still made in full; before that, crashed
+  // snakes leave the board instead.
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (!snakes.alive[s]) continue;
+    if (game.crash[s] && !game.over) {
+      removeSnake(game, s, !growing[s]);
+      continue;
+    }
+    snakes.pushHead(s, snakes.direction[s]);
+    if (!growing[s]) snakes.popTail(s);
+    game.bodyGrid.set(snakes.head[s]);
+
+    // Draw the new head of the snake
+    game.view->draw(snakes.head[s], SPRITE_SNAKE);
+  }
+
+  for (uint8_t s = 0; s < snakes.count; s++) {
+    if (!snakes.alive[s]) continue;
+
+    // Check if the snake eats the food
+    if (snakes.head[s] == game.food) eatFood(game, s);
+
+    // Checking if the snake has eaten bad food
+    if (game.badFoodGrid.test(snakes.head[s])) {
+      game.points[s]--;
+      game.view->sound(SOUND_BAD_FOOD_EATEN);
+      changeLevel(game);
+      if (snakes.length[s] > 1) {
+        game.bodyGrid.reset(snakes.tail[s]);
+        game.view->erase(snakes.tail[s]);
+        snakes.popTail(s); // Reduce snake length
+      }
+    }
+    if (game.crash[s]) snakes.alive[s] = false;
+  }
+
+  // Timed entities whose time came during this move
+  uint8_t timer;
+  while ((timer = game.timers.expire(game.clock)) != WHEEL_NONE) {
+    switch (timer) {
+      case TIMER_FOOD: expireFood(game); break;
+    }
+  }
+}
@@ -0,0 +1,350 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "hal.h"
+#include "audio.h"
+#include "profiler.h"
+
+//=================================================================
+// ATmega328PB board wiring
+
+#define TFT_CS 10
+#define TFT_DC 9
+#define BUZZER 5      // output pin for buzzer
+#define mouseButton 3 // input pin for the mouse pushButton
+#define X_CHANNEL 0   // joystick X axis on A0
+#define Y_CHANNEL 1   // joystick Y axis on A1
+#define NOISE_PIN 4   // floating analog pin, read for the seed
+#define SERIAL_BAUD 500000  // exact from 16 MHz, and a standard rate for the host
+
+// Power-down
+#define SLEEP_POLL WDTO_250MS        // watchdog period, HAL_SLEEP_POLL_MS
+#define WAKE_STARTUP_CYCLES 16384UL  // crystal start-up after power-down with the Arduino fuses, the cycle counter misses it
+#define WAKE_SETTLE_TICKS 5          // after a watchdog wake-up, both axes have been sampled again
+#define WAKE_DEFLECTION (AXIS_MAX / 4)  // stick travel from the centre that counts as moving it
+
+static Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC);
+static volatile uint16_t ticks = 0;
+// Background EEPROM write, fed to the EEPROM-ready interrupt
+static uint8_t eepromData[HAL_EEPROM_WRITE_MAX];
+static uint16_t eepromAddress;
+static volatile uint8_t eepromNext = 0;    // index of the next byte to write
+static volatile uint8_t eepromLength = 0;  // 0 when idle
+
+static volatile uint16_t cycleOverflows = 0;  // upper half of the cycle counter
+static uint16_t noise;  // NOISE_PIN reading, taken before the ADC is handed to the joystick
+
+// Joystick samples, written by the ADC interrupt
+static volatile JoystickSample latest = { (AXIS_MAX + 1) / 2, (AXIS_MAX + 1) / 2 };
+static volatile uint16_t pendingX;
+static JoystickSample samples[JOYSTICK_BUFFER];
+static volatile uint8_t sampleHead = 0;   // next sample to read
+static volatile uint8_t sampleCount = 0;
+
+// Button presses, timed for the wake latency
+static void (*buttonHandler)() = 0;
+static volatile uint32_t pressedAt;      // halCycles() at the press
+static volatile bool pressed = false;    // since the current wait began
+static bool serialWritten = false;       // TXC0 only means something once a byte has gone out
+
+// Timer1 compare A, CTC mode: exactly 1000 times per second
+ISR(TIMER1_COMPA_vect) {
+  ticks++;
+  audioTick();
+}
+
+// Wakes a powered-down CPU and keeps the tick count close to the time
+// that passed meanwhile
+ISR(WDT_vect) {
+  ticks += HAL_SLEEP_POLL_MS;
+}
+
+// The button's pin change, armed only while powered down: the INT1 edge
+// detector needs a running clock, so this press never reached it
+ISR(PCINT2_vect) {
+  if (PIND & _BV(PIND3)) return;  // released
+  pressedAt = halCycles() - WAKE_STARTUP_CYCLES;
+  pressed = true;
+  if (buttonHandler) buttonHandler();
+}
+
+// Timer3 counts every CPU cycle, its overflow extends it to 32 bits
+ISR(TIMER3_OVF_vect) {
+  cycleOverflows++;
+}
+
+// Fires whenever the EEPROM is free while enabled: start the next byte
+// that differs from what is stored, or switch off when none is left
+ISR(EE_READY_vect) {
+  while (eepromNext < eepromLength) {
+    uint16_t address = eepromAddress + eepromNext;
+    uint8_t value = eepromData[eepromNext++];
+    EEAR = address;
+    EECR |= _BV(EERE);
+    if (EEDR == value) continue;
+    EEDR = value;
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);  // within four cycles of EEMPE
+    return;
+  }
+  EECR &= ~_BV(EERIE);
+  eepromLength = 0;
+}
+
+// One conversion per Timer1 compare B match, alternating X and Y
+ISR(ADC_vect) {
+  uint16_t value = ADC;
+  TIFR1 = _BV(OCF1B);  // the trigger is the flag's rising edge, clear it for the next one
+  if ((ADMUX & 0x0F) == X_CHANNEL) {
+    pendingX = value;
+    ADMUX = (ADMUX & 0xF0) | Y_CHANNEL;
+    return;
+  }
+  ADMUX = (ADMUX & 0xF0) | X_CHANNEL;
+  latest.x = pendingX;
+  latest.y = value;
+
+  if (sampleCount == JOYSTICK_BUFFER) {
+    sampleHead = (sampleHead + 1) % JOYSTICK_BUFFER;  // drop the oldest
+    sampleCount--;
+  }
+  JoystickSample &sample = samples[(sampleHead + sampleCount) % JOYSTICK_BUFFER];
+  sample.x = pendingX;
+  sample.y = value;
+  sampleCount++;
+}
+
+void halBegin() {
+  pinMode(mouseButton, INPUT_PULLUP); // the mouse button
+  pinMode(BUZZER, OUTPUT);
+  Serial.begin(SERIAL_BAUD);  // start serial communication
+  noise = analogRead(NOISE_PIN);
+
+  // 16 MHz / 64 / 250 = 1 kHz
+  uint8_t state = halLock();
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+  TCNT1 = 0;
+  OCR1A = F_CPU / 64 / 1000 - 1;
+  OCR1B = OCR1A / 2;  // half a tick after the clock interrupt
+  TIMSK1 = _BV(OCIE1A);
+
+  // Timer3 free-running at the CPU clock
+  TCCR3A = 0;
+  TCCR3B = _BV(CS30);
+  TCNT3 = 0;
+  TIMSK3 = _BV(TOIE3);
+
+  // ADC auto-triggered by Timer1 compare B, 125 kHz conversion clock:
+  // 104 us per conversion and each axis sampled every 2 ms
+  DIDR0 = _BV(ADC0D) | _BV(ADC1D);
+  ADMUX = _BV(REFS0) | X_CHANNEL;
+  ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  halUnlock(state);
+}
+
+Display &halDisplay() {
+  return tft;
+}
+
+int halReadAxis(uint8_t axis) {
+  uint8_t state = halLock();
+  int value = axis == JOYSTICK_X ? latest.x : latest.y;
+  halUnlock(state);
+  return value;
+}
+
+bool halNextJoystickSample(JoystickSample &sample) {
+  uint8_t state = halLock();
+  bool found = sampleCount != 0;
+  if (found) {
+    sample = samples[sampleHead];
+    sampleHead = (sampleHead + 1) % JOYSTICK_BUFFER;
+    sampleCount--;
+  }
+  halUnlock(state);
+  return found;
+}
+
+bool halButtonDown() {
+  return digitalRead(mouseButton) == LOW;
+}
+
+static void buttonPress() {
+  pressedAt = halCycles();
+  pressed = true;
+  buttonHandler();
+}
+
+void halAttachButton(void (*onPress)()) {
+  buttonHandler = onPress;
+  attachInterrupt(digitalPinToInterrupt(mouseButton), buttonPress, FALLING);
+}
+
+uint16_t halTicks() {
+  // The counter is two bytes wide, read it with the timer interrupt held off
+  uint8_t state = halLock();
+  uint16_t now = ticks;
+  halUnlock(state);
+  return now;
+}
+
+uint32_t halCycles() {
+  uint8_t state = halLock();
+  uint16_t low = TCNT3;
+  uint16_t high = cycleOverflows;
+  if ((TIFR3 & _BV(TOV3)) && low < 0x8000) high++;  // wrapped, overflow not taken yet
+  halUnlock(state);
+  return ((uint32_t)high << 16) | low;
+}
+
+unsigned long halMillis() {
+  return millis();
+}
+
+void halDelay(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) halIdle();
+}
+
+static void wakeRecord() {
+  // Time from the press that ended the wait to here
+#ifdef SNAKE_PROFILE
+  if (pressed) profilerRecord(PROBE_WAKE, halCycles() - pressedAt);
+#endif
+}
+
+void halIdle() {
+  // CPU idle: the clocks, timers, ADC and serial port run on, and any
+  // interrupt wakes it, the 1 ms tick at the latest
+  pressed = false;
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+  wakeRecord();
+}
+
+static bool stickMoved() {
+  int x = halReadAxis(JOYSTICK_X) - (AXIS_MAX + 1) / 2;
+  int y = halReadAxis(JOYSTICK_Y) - (AXIS_MAX + 1) / 2;
+  return abs(x) > WAKE_DEFLECTION || abs(y) > WAKE_DEFLECTION;
+}
+
+static bool serialSending() {
+  // Bytes left in HardwareSerial's ring, or the last one still shifting out
+  return Serial.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1
+      || (serialWritten && !(UCSR0A & _BV(TXC0)));
+}
+
+void halSleep() {
+  for (;;) {
+    uint8_t state = halLock();
+    // A held button means a press is being handled or about to be, and
+    // powering down now would sit on it until the watchdog. The UART
+    // stops with the clock, so serial output has to be out first.
+    if (audioBusy() || halEepromBusy() || halButtonDown() || serialSending()) {
+      halUnlock(state);
+      halIdle();
+      return;
+    }
+    pressed = false;
+
+    // Wake sources: the button's pin change and the watchdog interrupt
+    PCMSK2 |= _BV(PCINT19);
+    PCIFR = _BV(PCIF2);
+    PCICR |= _BV(PCIE2);
+    MCUSR &= ~_BV(WDRF);  // a set WDRF would hold WDE on, and the watchdog would reset the board
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | SLEEP_POLL;  // within four cycles of WDCE
+
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sei();        // takes effect after the next instruction, a wake-up can't slip in between
+    sleep_cpu();
+    sleep_disable();
+
+    cli();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = 0;
+    PCICR &= ~_BV(PCIE2);
+    PCMSK2 &= ~_BV(PCINT19);
+    halUnlock(state);
+
+    if (pressed) break;
+
+    // Timer1 runs again, give the ADC a few ticks to sample the stick
+    uint16_t start = halTicks();
+    while ((uint16_t)(halTicks() - start) < WAKE_SETTLE_TICKS && !pressed) {
+      set_sleep_mode(SLEEP_MODE_IDLE);
+      sleep_mode();
+    }
+    if (pressed || stickMoved()) break;
+  }
+  wakeRecord();
+}
+
+void halSerialWrite(const char *text) {
+  Serial.print(text);
+  serialWritten = true;
+}
+
+void halSerialWrite(const __FlashStringHelper *text) {
+  Serial.print(text);
+  serialWritten = true;
+}
+
+int halSerialRead() {
+  return Serial.read();
+}
+
+bool halSerialSend(const uint8_t *data, uint8_t length) {
+  // HardwareSerial's ring is fed out by the data-register-empty interrupt,
+  // and write() only blocks when it runs out of room
+  if (Serial.availableForWrite() < length) return false;
+  Serial.write(data, length);
+  serialWritten = true;
+  return true;
+}
+
+void halTone(uint16_t frequency) {
+  if (frequency) tone(BUZZER, frequency);
+  else noTone(BUZZER);
+}
+
+uint8_t halEepromRead(uint16_t address) {
+  while (halEepromBusy()) {}
+  EEAR = address;
+  EECR |= _BV(EERE);
+  return EEDR;
+}
+
+bool halEepromWrite(uint16_t address, const uint8_t *data, uint8_t length) {
+  if (halEepromBusy() || length > HAL_EEPROM_WRITE_MAX) return false;
+  memcpy(eepromData, data, length);
+  eepromAddress = address;
+  eepromNext = 0;
+  eepromLength = length;
+  EECR |= _BV(EERIE);  // the interrupt fires straight away and takes it from here
+  return true;
+}
+
+bool halEepromBusy() {
+  return eepromLength != 0 || (EECR & _BV(EEPE));
+}
+
+uint32_t halEntropy() {
+  return ((uint32_t)noise << 16) ^ micros();  // floating pin noise
+}
+
+uint8_t halLock() {
+  uint8_t state = SREG;
+  cli();
+  return state;
+}
+
+void halUnlock(uint8_t state) {
+  SREG = state;
+}
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "hal.h"
+#include "audio.h"
+
+//=================================================================
+// Linux host. Time is the wall clock, the EEPROM is a file and the
+// joystick is scripted on stdin, one character per INPUT_HOLD ms:
+//   w a s d  push the stick up, left, down or right
+//   space    press the button
+//   .        leave the stick at rest
+//   anything else arrives on the serial port
+// The program ends when stdin does, and then reports the display traffic.
+//
+// The display model is set up from the environment:
+//   $SNAKE_FRAMES     directory each changed frame is saved to as PPM
+//   $SNAKE_FRAME_LOG  file that gets one CSV row of bus traffic per frame
+//   $SNAKE_SPI_HZ     SPI clock for the bus time, 8 MHz by default
+//   $SNAKE_CLOCK      "virtual" for a clock that only moves as the game
+//                     asks for the time, so a run with the same seed and
+//                     input file draws the same frames every time
+// and $SNAKE_TELEMETRY names a file for the binary serial frames, which
+// are dropped otherwise; scripts/telemetry_reader.py reads it.
+
+#define INPUT_HOLD 100                 // ms each input character lasts
+#define EEPROM_FILE "eeprom.bin"       // overridden by $SNAKE_EEPROM
+#define AXIS_REST ((AXIS_MAX + 1) / 2)  // reads as dead centre after scaling
+#define VIRTUAL_STEP_US 50             // virtual time every look at the clock costs
+
+static Display tft;
+static std::chrono::steady_clock::time_point epoch;
+static unsigned long clockMs = 0;      // time the audio and input have been run up to
+static bool virtualClock = false;
+static uint64_t virtualUs = 0;
+static FILE *frameLog = 0;
+static FILE *telemetry = 0;
+
+static int axis[2] = { AXIS_REST, AXIS_REST };
+static bool buttonDown = false;
+static unsigned long inputUntil = 0;   // when the current input character runs out
+static void (*buttonHandler)() = 0;
+
+static int serialByte = -1;           // received and not read yet
+
+static JoystickSample samples[JOYSTICK_BUFFER];
+static uint8_t sampleHead = 0;
+static uint8_t sampleCount = 0;
+
+static uint8_t eeprom[HAL_EEPROM_SIZE];
+static const char *eepromPath;
+
+static void nextInput() {
+  // APPLY THE NEXT SCRIPTED CHARACTER, OR REST WHEN NONE HAS ARRIVED YET
+  axis[JOYSTICK_X] = AXIS_REST;
+  axis[JOYSTICK_Y] = AXIS_REST;
+  buttonDown = false;
+
+  char c;
+  ssize_t got = read(STDIN_FILENO, &c, 1);
+  if (got == 0) exit(0);
+  if (got < 0) return;
+
+  // The stick is mounted turned: low X is right, high Y is up
+  switch (c) {
+    case 'w': axis[JOYSTICK_Y] = AXIS_MAX; break;
+    case 's': axis[JOYSTICK_Y] = 0; break;
+    case 'a': axis[JOYSTICK_X] = AXIS_MAX; break;
+    case 'd': axis[JOYSTICK_X] = 0; break;
+    case ' ':
+      buttonDown = true;
+      if (buttonHandler) buttonHandler();  // the falling edge
+      break;
+    case '.':
+    case '\n':
+      break;
+    default:
+      serialByte = (uint8_t)c;
+      break;
+  }
+}
+
+static void sampleJoystick() {
+  // The board takes a sample pair every 2 ms, the host one every ms
+  if (sampleCount == JOYSTICK_BUFFER) {
+    sampleHead = (sampleHead + 1) % JOYSTICK_BUFFER;  // drop the oldest
+    sampleCount--;
+  }
+  JoystickSample &sample = samples[(sampleHead + sampleCount) % JOYSTICK_BUFFER];
+  sample.x = axis[JOYSTICK_X];
+  sample.y = axis[JOYSTICK_Y];
+  sampleCount++;
+}
+
+static unsigned long elapsedMs() {
+  if (virtualClock) {
+    virtualUs += VIRTUAL_STEP_US;
+    return virtualUs / 1000;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - epoch).count();
+}
+
+static void reportDisplay() {
+  tft.endFrame();
+  tft.report(stderr);
+  if (frameLog) fclose(frameLog);
+}
+
+static unsigned long advance() {
+  // RUN THE TIMER AND PIN EVENTS THE BOARD WOULD HAVE SEEN SINCE THE LAST CALL
+  unsigned long now = elapsedMs();
+  for (; clockMs < now; clockMs++) {
+    audioTick();
+    if (clockMs >= inputUntil) {
+      nextInput();
+      inputUntil = clockMs + INPUT_HOLD;
+    }
+    sampleJoystick();
+  }
+  return now;
+}
+
+void halBegin() {
+  epoch = std::chrono::steady_clock::now();
+  fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+  for (uint16_t i = 0; i < HAL_EEPROM_SIZE; i++) eeprom[i] = 0xFF;
+  eepromPath = getenv("SNAKE_EEPROM");
+  if (!eepromPath) eepromPath = EEPROM_FILE;
+
+  const char *clock = getenv("SNAKE_CLOCK");
+  virtualClock = clock && strcmp(clock, "virtual") == 0;
+  const char *logPath = getenv("SNAKE_FRAME_LOG");
+  if (logPath && !(frameLog = fopen(logPath, "w"))) perror(logPath);
+  const char *spiHz = getenv("SNAKE_SPI_HZ");
+  tft.record(getenv("SNAKE_FRAMES"), frameLog, spiHz ? strtoul(spiHz, 0, 0) : 0);
+  atexit(reportDisplay);
+  const char *telemetryPath = getenv("SNAKE_TELEMETRY");
+  if (telemetryPath && !(telemetry = fopen(telemetryPath, "wb"))) perror(telemetryPath);
+  FILE *file = fopen(eepromPath, "rb");
+  if (file) {
+    if (fread(eeprom, 1, HAL_EEPROM_SIZE, file) != HAL_EEPROM_SIZE) {
+      fprintf(stderr, "%s: short EEPROM image, the rest reads erased\n", eepromPath);
+    }
+    fclose(file);
+  }
+}
+
+Display &halDisplay() {
+  return tft;
+}
+
+void halFrameEnd() {
+  tft.endFrame();
+}
+
+int halReadAxis(uint8_t which) {
+  return axis[which == JOYSTICK_X ? JOYSTICK_X : JOYSTICK_Y];
+}
+
+bool halNextJoystickSample(JoystickSample &sample) {
+  if (sampleCount == 0) return false;
+  sample = samples[sampleHead];
+  sampleHead = (sampleHead + 1) % JOYSTICK_BUFFER;
+  sampleCount--;
+  return true;
+}
+
+bool halButtonDown() {
+  return buttonDown;
+}
+
+void halAttachButton(void (*onPress)()) {
+  buttonHandler = onPress;
+}
+
+uint16_t halTicks() {
+  return advance();
+}
+
+unsigned long halMillis() {
+  return advance();
+}
+
+// Waiting ends a frame as well: whatever was drawn is on the screen now
+void halDelay(unsigned long ms) {
+  tft.endFrame();
+  unsigned long until = advance() + ms;
+  while (advance() < until) {
+    if (!virtualClock) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void halIdle() {
+  tft.endFrame();
+  if (virtualClock) virtualUs += 1000;
+  advance();
+  if (!virtualClock) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void halSleep() {
+  // Nothing to power down on the host, the clock keeps running
+  halIdle();
+}
+
+uint32_t halCycles() {
+  if (virtualClock) return virtualUs * HAL_CYCLES_PER_US;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - epoch).count() * HAL_CYCLES_PER_US / 1000;
+}
+
+void halSerialWrite(const char *text) {
+  fputs(text, stdout);
+  fflush(stdout);
+}
+
+void halSerialWrite(const __FlashStringHelper *text) {
+  halSerialWrite(reinterpret_cast<const char *>(text));
+}
+
+int halSerialRead() {
+  advance();
+  int c = serialByte;
+  serialByte = -1;
+  return c;
+}
+
+bool halSerialSend(const uint8_t *data, uint8_t length) {
+  if (telemetry) {
+    fwrite(data, 1, length, telemetry);
+    fflush(telemetry);
+  }
+  return true;
+}
+
+void halTone(uint16_t) {
+}
+
+uint8_t halEepromRead(uint16_t address) {
+  return address < HAL_EEPROM_SIZE ? eeprom[address] : 0xFF;
+}
+
+bool halEepromWrite(uint16_t address, const uint8_t *data, uint8_t length) {
+  // Done on the spot, the file stands in for the EEPROM after every write
+  if (length > HAL_EEPROM_WRITE_MAX || address + length > HAL_EEPROM_SIZE) return false;
+  memcpy(eeprom + address, data, length);
+  FILE *file = fopen(eepromPath, "wb");
+  if (!file) return true;
+  fwrite(eeprom, 1, HAL_EEPROM_SIZE, file);
+  fclose(file);
+  return true;
+}
+
+bool halEepromBusy() {
+  return false;
+}
+
+uint32_t halEntropy() {
+  // $SNAKE_SEED pins the first game down, otherwise time and pid vary it
+  const char *seed = getenv("SNAKE_SEED");
+  if (seed) return strtoul(seed, 0, 0);
+  return (uint32_t)time(0) ^ ((uint32_t)getpid() << 16);
+}
+
+uint8_t halLock() {
+  return 0;  // handlers run synchronously inside advance(), nothing to hold off
+}
+
+void halUnlock(uint8_t) {
+}
+
+//=================================================================
+// The Arduino core calls these for the sketch on the board
+
+void setup();
+void loop();
+
+int main() {
+  setup();
+  for (;;) loop();
+}
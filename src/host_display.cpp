@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <string.h>
+#include "host_display.h"
+
+//=================================================================
+// The classic 5x7 font of the Adafruit GFX library, printable ASCII
+// only: five columns per character, bit 0 at the top
+
+static const uint8_t font[] = {
+  0x00, 0x00, 0x00, 0x00, 0x00,  0x00, 0x00, 0x5F, 0x00, 0x00,  0x00, 0x07, 0x00, 0x07, 0x00,  // space ! "
+  0x14, 0x7F, 0x14, 0x7F, 0x14,  0x24, 0x2A, 0x7F, 0x2A, 0x12,  0x23, 0x13, 0x08, 0x64, 0x62,  // # $ %
+  0x36, 0x49, 0x56, 0x20, 0x50,  0x00, 0x08, 0x07, 0x03, 0x00,  0x00, 0x1C, 0x22, 0x41, 0x00,  // & ' (
+  0x00, 0x41, 0x22, 0x1C, 0x00,  0x2A, 0x1C, 0x7F, 0x1C, 0x2A,  0x08, 0x08, 0x3E, 0x08, 0x08,  // ) * +
+  0x00, 0x80, 0x70, 0x30, 0x00,  0x08, 0x08, 0x08, 0x08, 0x08,  0x00, 0x00, 0x60, 0x60, 0x00,  // , - .
+  0x20, 0x10, 0x08, 0x04, 0x02,  0x3E, 0x51, 0x49, 0x45, 0x3E,  0x00, 0x42, 0x7F, 0x40, 0x00,  // / 0 1
+  0x72, 0x49, 0x49, 0x49, 0x46,  0x21, 0x41, 0x49, 0x4D, 0x33,  0x18, 0x14, 0x12, 0x7F, 0x10,  // 2 3 4
+  0x27, 0x45, 0x45, 0x45, 0x39,  0x3C, 0x4A, 0x49, 0x49, 0x31,  0x41, 0x21, 0x11, 0x09, 0x07,  // 5 6 7
+  0x36, 0x49, 0x49, 0x49, 0x36,  0x46, 0x49, 0x49, 0x29, 0x1E,  0x00, 0x00, 0x14, 0x00, 0x00,  // 8 9 :
+  0x00, 0x40, 0x34, 0x00, 0x00,  0x00, 0x08, 0x14, 0x22, 0x41,  0x14, 0x14, 0x14, 0x14, 0x14,  // ; < =
+  0x00, 0x41, 0x22, 0x14, 0x08,  0x02, 0x01, 0x59, 0x09, 0x06,  0x3E, 0x41, 0x5D, 0x59, 0x4E,  // > ? @
+  0x7C, 0x12, 0x11, 0x12, 0x7C,  0x7F, 0x49, 0x49, 0x49, 0x36,  0x3E, 0x41, 0x41, 0x41, 0x22,  // A B C
+  0x7F, 0x41, 0x41, 0x41, 0x3E,  0x7F, 0x49, 0x49, 0x49, 0x41,  0x7F, 0x09, 0x09, 0x09, 0x01,  // D E F
+  0x3E, 0x41, 0x41, 0x51, 0x73,  0x7F, 0x08, 0x08, 0x08, 0x7F,  0x00, 0x41, 0x7F, 0x41, 0x00,  // G H I
+  0x20, 0x40, 0x41, 0x3F, 0x01,  0x7F, 0x08, 0x14, 0x22, 0x41,  0x7F, 0x40, 0x40, 0x40, 0x40,  // J K L
+  0x7F, 0x02, 0x1C, 0x02, 0x7F,  0x7F, 0x04, 0x08, 0x10, 0x7F,  0x3E, 0x41, 0x41, 0x41, 0x3E,  // M N O
+  0x7F, 0x09, 0x09, 0x09, 0x06,  0x3E, 0x41, 0x51, 0x21, 0x5E,  0x7F, 0x09, 0x19, 0x29, 0x46,  // P Q R
+  0x26, 0x49, 0x49, 0x49, 0x32,  0x03, 0x01, 0x7F, 0x01, 0x03,  0x3F, 0x40, 0x40, 0x40, 0x3F,  // S T U
+  0x1F, 0x20, 0x40, 0x20, 0x1F,  0x3F, 0x40, 0x38, 0x40, 0x3F,  0x63, 0x14, 0x08, 0x14, 0x63,  // V W X
+  0x03, 0x04, 0x78, 0x04, 0x03,  0x61, 0x59, 0x49, 0x4D, 0x43,  0x00, 0x7F, 0x41, 0x41, 0x41,  // Y Z [
+  0x02, 0x04, 0x08, 0x10, 0x20,  0x41, 0x41, 0x41, 0x7F, 0x00,  0x04, 0x02, 0x01, 0x02, 0x04,  // \ ] ^
+  0x40, 0x40, 0x40, 0x40, 0x40,  0x00, 0x03, 0x07, 0x08, 0x00,  0x20, 0x54, 0x54, 0x78, 0x40,  // _ ` a
+  0x7F, 0x28, 0x44, 0x44, 0x38,  0x38, 0x44, 0x44, 0x44, 0x28,  0x38, 0x44, 0x44, 0x28, 0x7F,  // b c d
+  0x38, 0x54, 0x54, 0x54, 0x18,  0x00, 0x08, 0x7E, 0x09, 0x02,  0x18, 0xA4, 0xA4, 0x9C, 0x78,  // e f g
+  0x7F, 0x08, 0x04, 0x04, 0x78,  0x00, 0x44, 0x7D, 0x40, 0x00,  0x20, 0x40, 0x40, 0x3D, 0x00,  // h i j
+  0x7F, 0x10, 0x28, 0x44, 0x00,  0x00, 0x41, 0x7F, 0x40, 0x00,  0x7C, 0x04, 0x78, 0x04, 0x78,  // k l m
+  0x7C, 0x08, 0x04, 0x04, 0x78,  0x38, 0x44, 0x44, 0x44, 0x38,  0xFC, 0x18, 0x24, 0x24, 0x18,  // n o p
+  0x18, 0x24, 0x24, 0x18, 0xFC,  0x7C, 0x08, 0x04, 0x04, 0x08,  0x48, 0x54, 0x54, 0x54, 0x24,  // q r s
+  0x04, 0x04, 0x3F, 0x44, 0x24,  0x3C, 0x40, 0x40, 0x20, 0x7C,  0x1C, 0x20, 0x40, 0x20, 0x1C,  // t u v
+  0x3C, 0x40, 0x30, 0x40, 0x3C,  0x44, 0x28, 0x10, 0x28, 0x44,  0x4C, 0x90, 0x90, 0x90, 0x7C,  // w x y
+  0x44, 0x64, 0x54, 0x4C, 0x44,  0x00, 0x08, 0x36, 0x41, 0x00,  0x00, 0x00, 0x77, 0x00, 0x00,  // z { |
+  0x00, 0x41, 0x36, 0x08, 0x00,  0x02, 0x01, 0x02, 0x04, 0x02,                                 // } ~
+};
+
+#define FONT_FIRST ' '
+#define FONT_LAST '~'
+
+//=================================================================
+
+void DisplayTraffic::add(const DisplayTraffic &other) {
+  transactions += other.transactions;
+  commands += other.commands;
+  windows += other.windows;
+  dataBytes += other.dataBytes;
+  pixels += other.pixels;
+}
+
+uint32_t DisplayTraffic::busMicros(uint32_t spiHz) const {
+  uint64_t clocks = (uint64_t)(commands + dataBytes) * (8 + DISPLAY_BYTE_GAP);
+  return clocks * 1000000 / spiHz + (uint64_t)transactions * DISPLAY_TRANSACTION_NS / 1000;
+}
+
+Display::Display()
+  : _width(ILI9341_TFTWIDTH), _height(ILI9341_TFTHEIGHT), cursorX(0), cursorY(0),
+    textColor(ILI9341_WHITE), textBackground(ILI9341_WHITE), textSize(1), rotation(0),
+    windowX1(0), windowX2(0), windowY1(0), windowY2(0), writeX(0), writeY(0),
+    sentX1(0xFFFF), sentX2(0xFFFF), sentY1(0xFFFF), sentY2(0xFFFF),
+    traffic(), total(), frames(0), worstMicros(0), worstFrame(0), changed(false),
+    frameDirectory(0), frameLog(0), spiHz(DISPLAY_SPI_HZ) {
+  memset(frame, 0, sizeof(frame));
+}
+
+void Display::begin(uint32_t) {
+  // The panel's own set-up sequence is not part of any frame
+}
+
+void Display::setRotation(uint8_t r) {
+  // Same mapping as the driver: odd rotations are landscape
+  rotation = r & 3;
+  _width = (rotation & 1) ? ILI9341_TFTHEIGHT : ILI9341_TFTWIDTH;
+  _height = (rotation & 1) ? ILI9341_TFTWIDTH : ILI9341_TFTHEIGHT;
+  traffic.transactions++;
+  traffic.commands++;   // ILI9341_MADCTL
+  traffic.dataBytes++;
+}
+
+void Display::fillScreen(uint16_t color) {
+  fillRect(0, 0, _width, _height, color);
+}
+
+void Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  startWrite();
+  writeFillRect(x, y, w, h, color);
+  endWrite();
+}
+
+void Display::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  startWrite();
+  writeFillRect(x, y, w, 1, color);
+  writeFillRect(x, y + h - 1, w, 1, color);
+  writeFillRect(x, y, 1, h, color);
+  writeFillRect(x + w - 1, y, 1, h, color);
+  endWrite();
+}
+
+void Display::startWrite() {
+  traffic.transactions++;
+}
+
+void Display::endWrite() {
+}
+
+void Display::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  // Clipped to the screen first, like the driver
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width) w = _width - x;
+  if (y + h > _height) h = _height - y;
+  if (w <= 0 || h <= 0) return;
+  setAddrWindow(x, y, w, h);
+  writeColor(color, (uint32_t)w * h);
+}
+
+void Display::setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  // A column or page range equal to the last one sent is skipped
+  uint16_t x2 = x + w - 1;
+  uint16_t y2 = y + h - 1;
+  if (x != sentX1 || x2 != sentX2) {
+    traffic.commands++;   // ILI9341_CASET
+    traffic.dataBytes += 4;
+    sentX1 = x;
+    sentX2 = x2;
+  }
+  if (y != sentY1 || y2 != sentY2) {
+    traffic.commands++;   // ILI9341_PASET
+    traffic.dataBytes += 4;
+    sentY1 = y;
+    sentY2 = y2;
+  }
+  traffic.commands++;     // ILI9341_RAMWR
+  traffic.windows++;
+  windowX1 = x;
+  windowX2 = x2;
+  windowY1 = y;
+  windowY2 = y2;
+  writeX = x;
+  writeY = y;
+}
+
+void Display::store(uint16_t color) {
+  // The controller fills its window row by row and wraps to the top
+  if (writeX < _width && writeY < _height) frame[writeY * _width + writeX] = color;
+  if (writeX++ == windowX2) {
+    writeX = windowX1;
+    if (writeY++ == windowY2) writeY = windowY1;
+  }
+}
+
+void Display::writeColor(uint16_t color, uint32_t count) {
+  traffic.dataBytes += count * 2;
+  traffic.pixels += count;
+  changed = true;
+  while (count--) store(color);
+}
+
+void Display::writePixels(uint16_t *colors, uint32_t len, bool, bool) {
+  traffic.dataBytes += len * 2;
+  traffic.pixels += len;
+  changed = true;
+  for (uint32_t i = 0; i < len; i++) store(colors[i]);
+}
+
+void Display::writePixel(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+  setAddrWindow(x, y, 1, 1);
+  writeColor(color, 1);
+}
+
+void Display::setCursor(int16_t x, int16_t y) {
+  cursorX = x;
+  cursorY = y;
+}
+
+void Display::setTextColor(uint16_t color) {
+  // Like the driver: background equal to foreground means transparent
+  textColor = color;
+  textBackground = color;
+}
+
+void Display::setTextColor(uint16_t color, uint16_t background) {
+  textColor = color;
+  textBackground = background;
+}
+
+void Display::setTextSize(uint8_t size) {
+  textSize = size ? size : 1;
+}
+
+void Display::drawChar(int16_t x, int16_t y, char c) {
+  // As the library does it: one window per font pixel, the background
+  // only when it is opaque, and the spacing column after the glyph
+  if (x >= _width || y >= _height || x + 6 * textSize - 1 < 0 || y + 8 * textSize - 1 < 0) return;
+  if (c < FONT_FIRST || c > FONT_LAST) c = '?';
+  const uint8_t *glyph = font + (c - FONT_FIRST) * 5;
+  bool opaque = textBackground != textColor;
+  startWrite();
+  for (uint8_t i = 0; i < 5; i++) {
+    uint8_t line = glyph[i];
+    for (uint8_t j = 0; j < 8; j++, line >>= 1) {
+      if (!(line & 1) && !opaque) continue;
+      uint16_t color = (line & 1) ? textColor : textBackground;
+      if (textSize == 1) writePixel(x + i, y + j, color);
+      else writeFillRect(x + i * textSize, y + j * textSize, textSize, textSize, color);
+    }
+  }
+  if (opaque) writeFillRect(x + 5 * textSize, y, textSize, 8 * textSize, textBackground);
+  endWrite();
+}
+
+void Display::print(const __FlashStringHelper *text) {
+  print(reinterpret_cast<const char *>(text));
+}
+
+void Display::print(const char *text) {
+  // Advance the cursor as the driver does, wrapping at the right edge
+  for (; *text; text++) {
+    if (*text == '\n') {
+      cursorX = 0;
+      cursorY += 8 * textSize;
+      continue;
+    }
+    if (*text == '\r') continue;
+    if (cursorX + 6 * textSize > _width) {
+      cursorX = 0;
+      cursorY += 8 * textSize;
+    }
+    drawChar(cursorX, cursorY, *text);
+    cursorX += 6 * textSize;
+  }
+}
+
+void Display::print(int value) {
+  print((long)value);
+}
+
+void Display::print(unsigned int value) {
+  print((unsigned long)value);
+}
+
+void Display::print(long value) {
+  char text[12];
+  snprintf(text, sizeof(text), "%ld", value);
+  print(text);
+}
+
+void Display::print(unsigned long value) {
+  char text[12];
+  snprintf(text, sizeof(text), "%lu", value);
+  print(text);
+}
+
+//=================================================================
+// Frames
+
+void Display::record(const char *directory, FILE *log, uint32_t hz) {
+  frameDirectory = directory;
+  frameLog = log;
+  spiHz = hz ? hz : DISPLAY_SPI_HZ;
+  if (frameLog) fprintf(frameLog, "frame,transactions,commands,windows,data_bytes,pixels,bus_us\n");
+}
+
+bool Display::saveFrame(const char *path) const {
+  // Binary PPM, RGB565 widened to 8 bits per channel
+  FILE *file = fopen(path, "wb");
+  if (!file) return false;
+  fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+  for (int32_t i = 0; i < (int32_t)_width * _height; i++) {
+    uint16_t color = frame[i];
+    uint8_t rgb[3] = {
+      (uint8_t)((color >> 11) * 255 / 31),
+      (uint8_t)(((color >> 5) & 0x3F) * 255 / 63),
+      (uint8_t)((color & 0x1F) * 255 / 31)
+    };
+    fwrite(rgb, 1, 3, file);
+  }
+  return fclose(file) == 0;
+}
+
+void Display::endFrame() {
+  // FRAMES WITHOUT ANY TRAFFIC ARE NOT COUNTED
+  if (traffic.transactions == 0) return;
+  frames++;
+  uint32_t micros = traffic.busMicros(spiHz);
+  if (micros > worstMicros) {
+    worstMicros = micros;
+    worstFrame = frames;
+  }
+  if (frameLog) {
+    fprintf(frameLog, "%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", (unsigned long)frames,
+            (unsigned long)traffic.transactions, (unsigned long)traffic.commands,
+            (unsigned long)traffic.windows, (unsigned long)traffic.dataBytes,
+            (unsigned long)traffic.pixels, (unsigned long)micros);
+  }
+  if (frameDirectory && changed) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame%06lu.ppm", frameDirectory, (unsigned long)frames);
+    if (!saveFrame(path)) {
+      fprintf(stderr, "%s: cannot write, frames are no longer saved\n", path);
+      frameDirectory = 0;
+    }
+  }
+  total.add(traffic);
+  traffic = DisplayTraffic();
+  changed = false;
+}
+
+void Display::report(FILE *out) const {
+  if (frames == 0) return;
+  fprintf(out, "display: %lu frames at %lu Hz SPI, per frame %.1f transactions, %.1f commands, "
+          "%.1f windows, %.0f data bytes, %.0f us on the bus; busiest frame %lu, %lu us\n",
+          (unsigned long)frames, (unsigned long)spiHz,
+          (double)total.transactions / frames, (double)total.commands / frames,
+          (double)total.windows / frames, (double)total.dataBytes / frames,
+          (double)total.busMicros(spiHz) / frames, (unsigned long)worstFrame, (unsigned long)worstMicros);
+}
@@ -0,0 +1,161 @@
+#include "hud.h"
+#include "profiler.h"
+
+//=================================================================
+// Digit glyphs, rasterised by the compiler from the 5x7 columns of the
+// built-in font. Each row is 12 bits, most significant bit leftmost.
+
+namespace {
+
+constexpr uint8_t digitFont[10][5] = {
+  {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+  {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33},
+  {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39},
+  {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+  {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E},
+};
+
+// Every font pixel becomes 2x2 glyph pixels, the sixth column is spacing
+constexpr uint16_t scaledRow(uint8_t digit, uint8_t row, uint8_t col = 0) {
+  return col == 5 ? 0
+       : (((digitFont[digit][col] >> (row / 2)) & 1) ? (3u << (10 - 2 * col)) : 0)
+         | scaledRow(digit, row, col + 1);
+}
+
+}
+
+#define GLYPH(d) { scaledRow(d, 0), scaledRow(d, 1), scaledRow(d, 2), scaledRow(d, 3), \
+                   scaledRow(d, 4), scaledRow(d, 5), scaledRow(d, 6), scaledRow(d, 7), \
+                   scaledRow(d, 8), scaledRow(d, 9), scaledRow(d, 10), scaledRow(d, 11), \
+                   scaledRow(d, 12), scaledRow(d, 13), scaledRow(d, 14), scaledRow(d, 15) }
+
+#define GLYPH_BLANK 10
+
+// Digits 0-9, then a blank glyph for unused places
+static const uint16_t digitGlyphs[11][HUD_GLYPH_H] PROGMEM = {
+  GLYPH(0), GLYPH(1), GLYPH(2), GLYPH(3), GLYPH(4),
+  GLYPH(5), GLYPH(6), GLYPH(7), GLYPH(8), GLYPH(9),
+  {0},
+};
+
+//=================================================================
+// Number fields remember which glyph is on screen in every place
+
+#define HUD_MAX_DIGITS 5
+#define GLYPH_UNKNOWN 0xFF
+
+struct HudField {
+  int16_t x;
+  int16_t y;
+  uint8_t places;
+  uint8_t shown[HUD_MAX_DIGITS];
+};
+
+enum CountdownState : uint8_t { COUNTDOWN_HIDDEN, COUNTDOWN_RUNNING, COUNTDOWN_MISSED };
+
+static Display *tft;
+static HudField scoreField = { HUD_SCORE_X + 7 * HUD_GLYPH_W, HUD_SCORE_Y, 5, {0} };       // after "Score: "
+static HudField levelField = { HUD_LEVEL_X + 6 * HUD_GLYPH_W, HUD_LEVEL_Y, 3, {0} };       // after "Level "
+static HudField countdownField = { HUD_COUNTDOWN_X + 6 * HUD_GLYPH_W, HUD_COUNTDOWN_Y, 1, {0} };  // after "Food: "
+static CountdownState countdownState = COUNTDOWN_HIDDEN;
+
+static void blitGlyph(int16_t x, int16_t y, uint8_t glyph) {
+  // ONE ADDRESS WINDOW, 192 PIXELS STREAMED ROW BY ROW
+  uint16_t line[HUD_GLYPH_W];
+  tft->startWrite();
+  tft->setAddrWindow(x, y, HUD_GLYPH_W, HUD_GLYPH_H);
+  for (uint8_t row = 0; row < HUD_GLYPH_H; row++) {
+    uint16_t bits = pgm_read_word(&digitGlyphs[glyph][row]);
+    for (uint8_t col = 0; col < HUD_GLYPH_W; col++) {
+      line[col] = (bits & (0x800 >> col)) ? ILI9341_WHITE : ILI9341_BLACK;
+    }
+    tft->writePixels(line, HUD_GLYPH_W);
+  }
+  tft->endWrite();
+}
+
+static void forget(HudField &field) {
+  for (uint8_t i = 0; i < field.places; i++) field.shown[i] = GLYPH_UNKNOWN;
+}
+
+static void showNumber(HudField &field, unsigned int value) {
+  // Left aligned like print(), places past the last digit are blank
+  PROFILE(PROBE_HUD);
+  uint8_t digits[HUD_MAX_DIGITS];
+  uint8_t count = 0;
+  do {
+    digits[count++] = value % 10;
+    value /= 10;
+  } while (value && count < field.places);
+
+  for (uint8_t i = 0; i < field.places; i++) {
+    uint8_t glyph = i < count ? digits[count - 1 - i] : GLYPH_BLANK;
+    if (glyph == field.shown[i]) continue;  // unchanged place, nothing to send
+    blitGlyph(field.x + i * HUD_GLYPH_W, field.y, glyph);
+    field.shown[i] = glyph;
+  }
+}
+
+void hudBegin(Display &display) {
+  tft = &display;
+}
+
+void hudReset() {
+  tft->setTextColor(ILI9341_WHITE);
+  tft->setTextSize(2);
+  tft->setCursor(HUD_SCORE_X, HUD_SCORE_Y);
+  tft->print(F("Score: "));
+  tft->setCursor(HUD_LEVEL_X, HUD_LEVEL_Y);
+  tft->print(F("Level "));
+  forget(scoreField);
+  forget(levelField);
+  countdownState = COUNTDOWN_HIDDEN;
+}
+
+static void clearLine(const HudField &field, int16_t labelX) {
+  tft->fillRect(labelX, field.y, field.x + field.places * HUD_GLYPH_W - labelX, HUD_GLYPH_H, ILI9341_BLACK);
+}
+
+void hudClear() {
+  // Only the text lines, the rest of the bands was never drawn on
+  clearLine(scoreField, HUD_SCORE_X);
+  clearLine(levelField, HUD_LEVEL_X);
+  if (countdownState != COUNTDOWN_HIDDEN) {
+    tft->fillRect(HUD_COUNTDOWN_X, HUD_COUNTDOWN_Y, 8 * HUD_GLYPH_W, HUD_GLYPH_H, ILI9341_BLACK);
+    countdownState = COUNTDOWN_HIDDEN;
+  }
+}
+
+void hudSetScore(unsigned int points) {
+  showNumber(scoreField, points);
+}
+
+void hudSetLevel(unsigned int level) {
+  showNumber(levelField, level);
+}
+
+void hudSetCountdown(unsigned int seconds) {
+  if (countdownState != COUNTDOWN_RUNNING) {
+    // "Missed!" or nothing was there, lay down the static parts once
+    tft->fillRect(HUD_COUNTDOWN_X, HUD_COUNTDOWN_Y, 8 * HUD_GLYPH_W, HUD_GLYPH_H, ILI9341_BLACK);
+    tft->setTextColor(ILI9341_WHITE);
+    tft->setTextSize(2);
+    tft->setCursor(HUD_COUNTDOWN_X, HUD_COUNTDOWN_Y);
+    tft->print(F("Food: "));
+    tft->setCursor(countdownField.x + HUD_GLYPH_W, HUD_COUNTDOWN_Y);
+    tft->print(F("s"));
+    forget(countdownField);
+    countdownState = COUNTDOWN_RUNNING;
+  }
+  showNumber(countdownField, seconds > 9 ? 9 : seconds);
+}
+
+void hudCountdownMissed() {
+  if (countdownState == COUNTDOWN_MISSED) return;
+  tft->fillRect(HUD_COUNTDOWN_X, HUD_COUNTDOWN_Y, 8 * HUD_GLYPH_W, HUD_GLYPH_H, ILI9341_BLACK);
+  tft->setTextColor(ILI9341_WHITE);
+  tft->setTextSize(2);
+  tft->setCursor(HUD_COUNTDOWN_X, HUD_COUNTDOWN_Y);
+  tft->print(F("Missed!"));
+  countdownState = COUNTDOWN_MISSED;
+}
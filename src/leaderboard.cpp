@@ -0,0 +1,110 @@
+#include <stddef.h>
+#include <string.h>
+#include "leaderboard.h"
+#include "crc16.h"
+
+#define LEGACY_HIGH_SCORE_ADDRESS 0
+#define EMPTY_SEQUENCE 0xFFFF  // erased slot
+
+// One slot of the ring
+struct Record {
+  uint16_t sequence;  // counts up by one per record, wraps
+  uint16_t scores[LEADERBOARD_SIZE];
+  uint16_t crc;       // over everything before it
+};
+
+static_assert(sizeof(Record) <= LEADERBOARD_SLOT, "record must fit its slot");
+static_assert(sizeof(Record) <= HAL_EEPROM_WRITE_MAX, "record must fit one background write");
+static_assert(LEADERBOARD_SLOTS <= 32, "the boot scan tracks rejected slots in 32 bits");
+static_assert(LEADERBOARD_ADDRESS + LEADERBOARD_SLOTS * LEADERBOARD_SLOT <= HAL_EEPROM_SIZE, "ring must fit the EEPROM");
+
+static Record current;       // what the newest slot holds, or will once saved
+static uint8_t currentSlot;  // slot of the newest record
+static bool unsaved = false;
+
+static uint16_t recordCrc(const Record &record) {
+  return crc16((const uint8_t *)&record, offsetof(Record, crc));
+}
+
+static uint16_t slotAddress(uint8_t slot) {
+  return LEADERBOARD_ADDRESS + slot * LEADERBOARD_SLOT;
+}
+
+static uint16_t readWord(uint16_t address) {
+  return halEepromRead(address) | (halEepromRead(address + 1) << 8);
+}
+
+static void readRecord(uint8_t slot, Record &record) {
+  uint8_t *bytes = (uint8_t *)&record;
+  for (uint8_t i = 0; i < sizeof(Record); i++) bytes[i] = halEepromRead(slotAddress(slot) + i);
+}
+
+// Sequence numbers wrap, so newer means a small positive distance
+static bool newer(uint16_t a, uint16_t b) {
+  return (int16_t)(a - b) > 0;
+}
+
+void leaderboardBegin() {
+  // SCAN THE SEQUENCE NUMBERS, THEN CHECK THE NEWEST RECORDS UNTIL ONE IS INTACT
+  uint16_t sequences[LEADERBOARD_SLOTS];
+  for (uint8_t slot = 0; slot < LEADERBOARD_SLOTS; slot++) sequences[slot] = readWord(slotAddress(slot));
+
+  uint32_t rejected = 0;
+  for (;;) {
+    int8_t newest = -1;
+    for (uint8_t slot = 0; slot < LEADERBOARD_SLOTS; slot++) {
+      if (sequences[slot] == EMPTY_SEQUENCE || (rejected & (1UL << slot))) continue;
+      if (newest < 0 || newer(sequences[slot], sequences[newest])) newest = slot;
+    }
+    if (newest < 0) break;
+
+    readRecord(newest, current);
+    if (recordCrc(current) == current.crc) {
+      currentSlot = newest;
+      unsaved = false;
+      return;
+    }
+    rejected |= 1UL << newest;
+  }
+
+  // Nothing usable: start empty, keeping the high score of the single-cell layout
+  memset(&current, 0, sizeof(current));
+  current.sequence = EMPTY_SEQUENCE;  // the first save becomes sequence 0
+  currentSlot = LEADERBOARD_SLOTS - 1;
+  int16_t legacy = readWord(LEGACY_HIGH_SCORE_ADDRESS);
+  if (legacy > 0) {
+    current.scores[0] = legacy;
+    unsaved = true;
+  }
+}
+
+uint16_t leaderboardScore(uint8_t rank) {
+  return rank < LEADERBOARD_SIZE ? current.scores[rank] : 0;
+}
+
+uint8_t leaderboardSubmit(uint16_t points) {
+  // Ties keep the older score ahead
+  uint8_t rank = 0;
+  while (rank < LEADERBOARD_SIZE && current.scores[rank] >= points) rank++;
+  if (rank == LEADERBOARD_SIZE || points == 0) return LEADERBOARD_SIZE;
+
+  for (uint8_t i = LEADERBOARD_SIZE - 1; i > rank; i--) current.scores[i] = current.scores[i - 1];
+  current.scores[rank] = points;
+  unsaved = true;
+  leaderboardPoll();
+  return rank;
+}
+
+void leaderboardPoll() {
+  // The record in RAM is only stamped when its write can start, so a
+  // burst of changes costs one slot
+  if (!unsaved || halEepromBusy()) return;
+  uint8_t slot = (currentSlot + 1) % LEADERBOARD_SLOTS;
+  Record record = current;
+  if (++record.sequence == EMPTY_SEQUENCE) record.sequence = 0;
+  record.crc = recordCrc(record);
+  if (!halEepromWrite(slotAddress(slot), (const uint8_t *)&record, sizeof(record))) return;
+  current = record;
+  currentSlot = slot;
+  unsaved = false;
+}
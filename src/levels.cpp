@@ -0,0 +1,71 @@
+#include "platform.h"
+#include "levels.h"
+
+//=================================================================
+// The curve itself. Everything below is evaluated by the compiler,
+// only the finished table ends up in the image.
+
+namespace {
+
+constexpr uint64_t power(uint64_t base, uint8_t exponent) {
+  return exponent == 0 ? 1 : base * power(base, exponent - 1);
+}
+
+constexpr uint16_t atLeastOne(uint64_t value) {
+  return value > 0 ? value : 1;
+}
+
+// 200 ms up to level 4, then 20% faster per level: 200 * 0.8^(level - 4)
+// computed exactly as 200 * 4^n / 5^n, never dropping below 1 ms
+// (past n = 23 the period is under 1 ms and 5^n would overflow)
+constexpr uint16_t tickPeriod(uint8_t level) {
+  return level < 5 ? 200
+       : level - 4 > 23 ? 1
+       : atLeastOne(200 * power(4, level - 4) / power(5, level - 4));
+}
+
+// Food starts disappearing after 5 seconds from level 3
+constexpr uint16_t foodLifetime(uint8_t level) {
+  return level >= 3 ? 5000 : 0;
+}
+
+// One bad food at level 4 and one more every level after it
+constexpr uint8_t badFoodCount(uint8_t level) {
+  return level >= 4 ? level - 3 : 0;
+}
+
+// A single barrier from level 2
+constexpr uint8_t barrierCount(uint8_t level) {
+  return level >= 2 ? 1 : 0;
+}
+
+constexpr LevelParams levelRow(uint8_t level) {
+  return LevelParams{tickPeriod(level), foodLifetime(level), badFoodCount(level), barrierCount(level)};
+}
+
+// Expand levelRow over 1..MAX_LEVEL
+template <uint8_t... Levels> struct LevelTable {
+  static const LevelParams rows[sizeof...(Levels)];
+};
+
+template <uint8_t... Levels>
+const LevelParams LevelTable<Levels...>::rows[sizeof...(Levels)] PROGMEM = { levelRow(Levels)... };
+
+template <uint8_t N, uint8_t... Levels> struct MakeLevelTable : MakeLevelTable<N - 1, N, Levels...> {};
+template <uint8_t... Levels> struct MakeLevelTable<0, Levels...> {
+  typedef LevelTable<Levels...> type;
+};
+
+typedef MakeLevelTable<MAX_LEVEL>::type Levels;
+
+static_assert(badFoodCount(MAX_LEVEL) <= MAX_BAD_FOOD, "bad food curve exceeds MAX_BAD_FOOD");
+static_assert(barrierCount(MAX_LEVEL) <= MAX_BARRIERS, "barrier curve exceeds MAX_BARRIERS");
+static_assert(tickPeriod(5) == 160 && tickPeriod(8) == 81, "speed curve must match 200 * 0.8^(level - 4)");
+
+}
+
+void loadLevel(unsigned int level, LevelParams &params) {
+  if (level < 1) level = 1;
+  if (level > MAX_LEVEL) level = MAX_LEVEL;
+  memcpy_P(&params, &Levels::rows[level - 1], sizeof(LevelParams));
+}
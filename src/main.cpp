@@ -1,47 +1,93 @@
-#include <Arduino.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_ILI9341.h>
-#include <SPI.h>
-#include <EEPROM.h>
-#include <math.h>
-#include <string.h>
-
-#define TFT_CS 10
-#define TFT_DC 9
-#define BUZZER 5      // output pin for buzzer
-#define mouseButton 3 // input pin for the mouse pushButton
-#define xAxis A0      // joystick X axis
-#define yAxis A1      // joystick Y axis
-
-#define SCREEN_WIDTH 240
-#define MAX_SNAKE_LENGTH 100
-#define MAX_BAD_FOOD 50
-#define X_BOUNDARY 10 // define the area of the screen for gameplay
-#define Y_BOUNDARY 40 // define the area of the screen for gameplay
-
-#define EEPROM_HIGH_SCORE_ADDRESS 0
-
-Adafruit_ILI9341 screen = Adafruit_ILI9341(TFT_CS,TFT_DC);
+#include <stdlib.h>
+#include "hal.h"
+#include "board.h"
+#include "engine.h"
+#include "audio.h"
+#include "scheduler.h"
+#include "render.h"
+#include "hud.h"
+#include "profiler.h"
+#include "leaderboard.h"
+#include "replay_store.h"
+#include "autopilot.h"
+#include "telemetry.h"
+
+Display &screen = halDisplay();
 
 //==========================FUNCTIONS==============================
 //=================================================================
 
-void screenDisplay(char str[], unsigned int y);
-int readAxis(int thisAxis);
-void menu();
+void screenDisplayAt(const __FlashStringHelper *str, int16_t x, uint8_t size, unsigned int y);
+// Centre a string literal; the text stays in flash and its position is worked out by the compiler
+#define screenDisplay(str, size, y) screenDisplayAt(F(str), CENTERED_X(str, size), size, y)
+int readAxis(uint8_t thisAxis);
+int scaleAxis(int reading);
 void menuNavigation(int move);
 void highlightMenuItem(int mode);
 void unhighlightMenuItem(int mode);
-void play();
-void highscore();
+enum PlayMode : uint8_t {
+  PLAY_GAME,    // the player steers
+  PLAY_REPLAY,  // the turns come from lastReplay
+  PLAY_DEMO     // the autopilot steers until the player touches the controls
+};
+
+// Every screen is a state with enter, update and exit hooks. loop() runs
+// the update of the current one, which does what is due and returns, and
+// screenGo() moves to the next. Timed screens count down on the
+// scheduler, so input, audio and telemetry never stop for a delay.
+enum Screen : uint8_t {
+  SCREEN_MENU,
+  SCREEN_PLAY,
+  SCREEN_GAME_OVER,   // the score over the last board, then the high scores
+  SCREEN_REPLAY_END,  // how the replay ended, over its board
+  SCREEN_DEMO_OVER,   // the last demo stays up a moment before the next
+  SCREEN_SCORES,
+  SCREEN_NO_REPLAY,
+  SCREENS
+};
+
+// What the loop may do once an update returns
+enum Rest : uint8_t {
+  REST_BUSY,   // go round again straight away
+  REST_IDLE,   // nothing is due before the next tick
+  REST_SLEEP   // nothing happens until the player acts
+};
+
+struct ScreenHooks {
+  void (*enter)();
+  Rest (*update)();
+  void (*exit)();   // clears what the screen drew, 0 for nothing to clear
+  bool overBoard;   // drawn over the last game's board, which is kept until then
+};
+
+void screenGo(Screen next);
+void startPlay(PlayMode mode);
+bool takePress();
+Rest holdThen(Screen next);
+void clearBoard();
+void wipeBand();
+void menuEnter();
+Rest menuUpdate();
+void menuExit();
+void playEnter();
+Rest playUpdate();
+void pauseGame(bool pause);
+void playReplay();
+void gameOverEnter();
+Rest gameOverUpdate();
+void panelExit();
+void replayEndEnter();
+Rest menuAfterHold();
+void demoOverEnter();
+Rest demoOverUpdate();
+void scoresEnter();
+void scoresExit();
+void noReplayEnter();
+void noReplayExit();
+void serialCommands();
 void updateScore(int points,int level);
-void gameOver(int points);
 void joystickISR();
 void displayCountdown(unsigned int remainingTime);
-void playSound(char sound[]);
-int readHighScore() ;
-void writeHighScore(int highScore) ;
-void displayBackButton();
 
 //=================================================================
 // Parameters for reading the joystick:
@@ -58,71 +104,253 @@ int xReading;
 int yReading;
 char lastMove = 'r';  // Initialize with a default direction
 volatile bool buttonPressed = false;
+uint16_t lastPress;   // tick of the last press acted on, for the debounce
+char remoteMove = 0;  // a turn sent by a host, taken in place of the stick by the next look at it
 int currentMode = 1;
 int previousMode = 1;
 int best;
 
-unsigned long foodSpawnTime = 0;  // Tracks when the food was generated
-bool foodVisible = true;          // Whether the food is currently visible
-const unsigned long foodDisappearTime = 5000;  // 5 seconds for food disappearance
-unsigned long lastUpdateTime = 0;
+Cadence menuCadence;
+unsigned long lastMenuInput = 0;  // the attract mode starts once the menu has been left alone for a while
+bool startPending = false;        // START was picked while the last game's replay is still being saved
+
+#define ATTRACT_DELAY 20000  // ms
+#define DEBOUNCE_PERIOD 200  // ms after a press in which the button is not heard again
+
+const ScreenHooks screens[SCREENS] = {
+  { menuEnter, menuUpdate, menuExit, false },           // SCREEN_MENU
+  { playEnter, playUpdate, 0, false },                  // SCREEN_PLAY, its board stays for the next screen
+  { gameOverEnter, gameOverUpdate, panelExit, true },   // SCREEN_GAME_OVER
+  { replayEndEnter, menuAfterHold, panelExit, true },   // SCREEN_REPLAY_END
+  { demoOverEnter, demoOverUpdate, 0, true },           // SCREEN_DEMO_OVER
+  { scoresEnter, menuAfterHold, scoresExit, false },    // SCREEN_SCORES
+  { noReplayEnter, menuAfterHold, noReplayExit, false } // SCREEN_NO_REPLAY
+};
 
-//=================================================================
-// Snake body
+Screen currentScreen = SCREEN_MENU;
+Cadence screenHold;       // how long a timed screen stays up
+bool boardShown = false;  // a game's board is on the screen
 
-struct SnakeSegment {
-  int x;
-  int y;
+#define GAME_OVER_HOLD 1000    // ms
+#define SCORES_HOLD 1500       // ms
+#define REPLAY_END_HOLD 1500   // ms
+#define NO_REPLAY_HOLD 1500    // ms
+#define DEMO_GAP 1000          // ms between two demo games
+
+// Timed updates during play, on a wheel in wall-clock time
+enum PlayTimer : uint8_t {
+  TIMER_COUNTDOWN,  // redraw the food countdown
+  PLAY_TIMERS
 };
 
+TimerWheel<PLAY_TIMERS> playTimers;
+
+#define COUNTDOWN_PERIOD 1000  // ms
+
+// Menu highlight bars, centred on any layout
+#define MENU_BAR_W 180
+#define MENU_BAR_X ((SCREEN_WIDTH - MENU_BAR_W) / 2)
+
+// The title and the three items all lie in this block, the width of the bars
+#define MENU_Y 40
+#define MENU_H 150
+
+// The display comes up with whatever its memory held. At boot only the
+// menu block is cleared before the menu is drawn; the rest of the screen
+// follows a band per loop pass, with the menu already taking input.
+#define WIPE_BAND 10  // rows per pass
+static_assert(MENU_Y % WIPE_BAND == 0 && MENU_H % WIPE_BAND == 0 && SCREEN_HEIGHT % WIPE_BAND == 0,
+              "bands start and end on the edges of the menu block");
+
+int16_t wipeRow = SCREEN_HEIGHT;  // first row the boot clear has not reached
+
+// White panel the game over and replay results are shown on, over the board
+#define PANEL_X 10
+#define PANEL_Y 70
+#define PANEL_W (SCREEN_WIDTH - 20)
+#define PANEL_H 140
+
+// High score list: the heading and one line per rank at text size 2
+#define SCORES_X 50
+#define SCORES_Y 50
+#define SCORES_W (11 * 12)  // "High Scores"
+#define SCORES_H (40 + (LEADERBOARD_SIZE - 1) * 30 + 16)
+
+#define NOTICE_Y 140  // "NO REPLAY"
+
+// "Game Paused!" box in the middle of the screen
+#define PAUSE_W 140
+#define PAUSE_X ((SCREEN_WIDTH - PAUSE_W) / 2)
+#define PAUSE_Y (SCREEN_HEIGHT / 2 - 20)
+
+uint32_t gameSeed;  // seed of the next game, every spawn follows from it
+Game game;
+Autopilot autopilot;
+
 //=================================================================
 void setup() {
-  pinMode(mouseButton, INPUT_PULLUP); // the mouse button
-  attachInterrupt(digitalPinToInterrupt(mouseButton), joystickISR, FALLING);
-
-  Serial.begin(9600);         // start serial communication
+  halBegin();
+  halAttachButton(joystickISR);
+  leaderboardBegin();
+  replayStoreBegin();
+  menuCadence.start(MENU_PERIOD, schedulerNow());
   screen.begin();
-  screen.setRotation(4);
-  screen.fillScreen(ILI9341_BLACK);
-  randomSeed(analogRead(4));
-  playSound("gameStartingMelody");
-  menu();
+  screen.setRotation(SCREEN_ROTATION);
+  screen.fillRect(MENU_BAR_X, MENU_Y, MENU_BAR_W, MENU_H, ILI9341_BLACK);  // the rest is wiped from loop()
+  wipeRow = 0;
+  renderBegin(screen);
+  hudBegin(screen);
+  gameSeed = halEntropy();  // seeds the first game
+  lastPress = schedulerNow() - DEBOUNCE_PERIOD;
+  playSound(SOUND_GAME_START);  // plays from the audio interrupt, the menu is up meanwhile
+  currentScreen = SCREEN_MENU;
+  menuEnter();
 }
 
 void loop() {
-  // Read and scale the two axes:
-  xReading = readAxis(xAxis);
-  yReading = readAxis(yAxis);
+  serialCommands();
+  leaderboardPoll();
+  replayStorePoll();
+  telemetryPoll();
+  if (wipeRow < SCREEN_HEIGHT) wipeBand();
+
+  // Let the current screen do what is due, then rest until there is more
+  switch (screens[currentScreen].update()) {
+    case REST_BUSY:
+      break;
+    case REST_IDLE:
+      halIdle();
+      break;
+    case REST_SLEEP:
+      // A host's button has to be heard, so a linked unit only idles
+      if (telemetryLinked()) halIdle();
+      else halSleep();
+      break;
+  }
+}
 
-  // Handle joystick movements in the game menu or game
-  menuNavigation(yReading);  // Move in the menu based on Y axis
+//Functions for moving between screens
+//=================================================================
+
+void screenGo(Screen next) {
+  //LEAVE THE CURRENT SCREEN FOR THE NEXT; EACH ONE CLEARS ONLY WHAT IT DREW
+  if (screens[currentScreen].exit) screens[currentScreen].exit();
+  if (boardShown && !screens[next].overBoard) clearBoard();
+  while (next != SCREEN_MENU && wipeRow < SCREEN_HEIGHT) wipeBand();  // only the menu fits the part cleared so far
+  currentScreen = next;
+  screens[next].enter();
+}
+
+bool takePress() {
+  //TAKE A BUTTON PRESS ONCE; BOUNCES RIGHT AFTER ONE ARE DROPPED
+  if (!buttonPressed) return false;
+  buttonPressed = false;
+  uint16_t now = schedulerNow();
+  if ((uint16_t)(now - lastPress) < DEBOUNCE_PERIOD) return false;
+  lastPress = now;
+  return true;
+}
+
+Rest holdThen(Screen next) {
+  //A TIMED SCREEN MOVES ON ONCE ITS TIME IS UP
+  if (!screenHold.due(schedulerNow())) return REST_IDLE;
+  screenGo(next);
+  return REST_BUSY;
+}
+
+Rest menuAfterHold() {
+  return holdThen(SCREEN_MENU);
+}
+
+void wipeBand() {
+  //CLEAR THE NEXT BAND OF THE BOOT SCREEN, AROUND THE MENU BLOCK
+  if (wipeRow >= MENU_Y && wipeRow < MENU_Y + MENU_H) {
+    screen.fillRect(0, wipeRow, MENU_BAR_X, WIPE_BAND, ILI9341_BLACK);
+    screen.fillRect(MENU_BAR_X + MENU_BAR_W, wipeRow, SCREEN_WIDTH - MENU_BAR_X - MENU_BAR_W, WIPE_BAND, ILI9341_BLACK);
+  } else {
+    screen.fillRect(0, wipeRow, SCREEN_WIDTH, WIPE_BAND, ILI9341_BLACK);
+  }
+  wipeRow += WIPE_BAND;
+}
+
+void clearBoard() {
+  //TAKE THE LAST GAME OFF THE SCREEN: ITS OCCUPIED CELLS, THE BORDER AND THE HUD TEXT
+  for (uint8_t row = 0; row < GRID_ROWS; row++) {
+    for (uint8_t col = 0; col < GRID_COLS; col++) {
+      Cell cell = { col, row };
+      if (game.bodyGrid.test(cell) || game.barrierGrid.test(cell) || game.badFoodGrid.test(cell) || cell == game.food) {
+        renderRect(cell.x(), cell.y(), CELL_SIZE, CELL_SIZE, ILI9341_BLACK);
+      }
+    }
+  }
+  renderRect(BORDER_X, BORDER_Y, BORDER_W, 1, ILI9341_BLACK);
+  renderRect(BORDER_X, BORDER_Y + BORDER_H - 1, BORDER_W, 1, ILI9341_BLACK);
+  renderRect(BORDER_X, BORDER_Y, 1, BORDER_H, ILI9341_BLACK);
+  renderRect(BORDER_X + BORDER_W - 1, BORDER_Y, 1, BORDER_H, ILI9341_BLACK);
+  renderFlush();
+  hudClear();
+  boardShown = false;
 }
 
 //Functions for start-up and menu navigation
 //=================================================================
 
-void screenDisplay(char str[], unsigned int y){
-  //DISPLAYS TEXT IN THE MIDDLE OF THE SCREEN
-
-  int16_t x1, y1; // variables for text coordinates
-  uint16_t w, h;  // variables for text width and height
-  screen.getTextBounds(str, 0, 0, &x1, &y1, &w, &h); // Get width of text
-  screen.setCursor((SCREEN_WIDTH - w) / 2, y); // Set cursor to the center
+void screenDisplayAt(const __FlashStringHelper *str, int16_t x, uint8_t size, unsigned int y){
+  //DISPLAYS TEXT IN THE MIDDLE OF THE SCREEN, x COMES FROM screenDisplay()
+  screen.setTextSize(size);
+  screen.setCursor(x, y);
   screen.print(str);
 }
 
-void menu(){
-  //DISPLAY THE MENU WITH THE TWO OPTIONS "SNAKE GAME" AND "HIGH SCORES"
+void menuEnter(){
+  //DISPLAY THE MENU WITH THE OPTIONS "START", "HIGH SCORES" AND "REPLAY"
 
-  screen.setTextSize(3);
   screen.setTextColor(ILI9341_RED);
-  screenDisplay("SNAKE GAME",40);
-  screen.fillRect(30,90,180,20,ILI9341_ORANGE);
+  screenDisplay("SNAKE GAME",3,MENU_Y);
+  screen.fillRect(MENU_BAR_X,90,MENU_BAR_W,20,ILI9341_ORANGE);
   screen.setTextColor(ILI9341_WHITE);
-  screen.setTextSize(2);
-  screenDisplay("START",90);
-  screenDisplay("HIGH SCORES",130);
+  screenDisplay("START",2,90);
+  screenDisplay("HIGH SCORES",2,130);
+  screenDisplay("REPLAY",2,170);
+
+  currentMode = previousMode = 1;  // the menu comes back with START highlighted
+  lastMenuInput = halMillis();
+  startPending = false;
+}
+
+Rest menuUpdate() {
+  // A new game records over the replay buffer, so it waits until the
+  // buffer has been saved from the last game; the loop keeps polling meanwhile
+  if (startPending) {
+    if (replayStoreBusy()) return REST_IDLE;
+    startPending = false;
+    startPlay(PLAY_GAME);
+    return REST_BUSY;
+  }
+
+  // Limit the menu to one move per MENU_PERIOD to prevent rapid menu navigation,
+  // and sleep in between
+  if (!menuCadence.due(schedulerNow())) return REST_IDLE;
+
+  // Read and scale the two axes:
+  xReading = readAxis(JOYSTICK_X);
+  yReading = readAxis(JOYSTICK_Y);
+  if (remoteMove == 'u' || remoteMove == 'd') yReading = remoteMove == 'u' ? 1 : -1;
+  remoteMove = 0;
+
+  // Handle joystick movements in the game menu
+  if (yReading != 0 || buttonPressed) lastMenuInput = halMillis();
+  menuNavigation(yReading);  // Move in the menu based on Y axis
+
+  // Left alone for a while, the menu gives way to the autopilot
+  if (currentScreen == SCREEN_MENU && halMillis() - lastMenuInput >= ATTRACT_DELAY) startPlay(PLAY_DEMO);
+  return REST_IDLE;
+}
 
+void menuExit() {
+  // The title line and the three item bars, not the gaps between them
+  screen.fillRect(MENU_BAR_X, MENU_Y, MENU_BAR_W, 24, ILI9341_BLACK);
+  for (int16_t y = 90; y <= 170; y += 40) screen.fillRect(MENU_BAR_X, y, MENU_BAR_W, 20, ILI9341_BLACK);
 }
 
 void menuNavigation(int move) {
@@ -131,9 +359,9 @@ void menuNavigation(int move) {
   // Calculate the new menu item based on joystick movement
   currentMode += (move > 0) ? -1 : (move < 0) ? 1 : 0;
   
-  // Limit currentMode to the range 1 to 2
-  if (currentMode < 1) currentMode = 2;
-  if (currentMode > 2) currentMode = 1;
+  // Limit currentMode to the range 1 to 3
+  if (currentMode < 1) currentMode = 3;
+  if (currentMode > 3) currentMode = 1;
 
   if (currentMode != previousMode) {
     // Unhighlight the previous menu item
@@ -146,20 +374,19 @@ void menuNavigation(int move) {
   }
 
   // Handle button press for the current menu item
-  if (buttonPressed) {
+  if (takePress()) {
     switch (currentMode) {
       case 1:
-        play();
+        startPending = true;  // menuUpdate() starts it
         break;
       case 2:
-        highscore(); 
+        screenGo(SCREEN_SCORES);
+        break;
+      case 3:
+        playReplay();
         break;
     }
-    buttonPressed = false;  // Reset the button press flag
   }
-
-  // Delay to prevent rapid menu navigation
-  delay(200);
 }
 
 void highlightMenuItem(int mode) {
@@ -167,14 +394,19 @@ void highlightMenuItem(int mode) {
 
   switch (mode) {
     case 1:
-      screen.fillRect(30, 90, 180, 20, ILI9341_ORANGE);  // Highlight START
-      screenDisplay("START", 90);
-      playSound("clickSound"); 
+      screen.fillRect(MENU_BAR_X, 90, MENU_BAR_W, 20, ILI9341_ORANGE);  // Highlight START
+      screenDisplay("START", 2, 90);
+      playSound(SOUND_CLICK); 
       break;
     case 2:
-      screen.fillRect(30, 130, 180, 20, ILI9341_ORANGE); // Highlight HIGHSCORES
-      screenDisplay("HIGH SCORES", 130);
-      playSound("clickSound"); 
+      screen.fillRect(MENU_BAR_X, 130, MENU_BAR_W, 20, ILI9341_ORANGE); // Highlight HIGHSCORES
+      screenDisplay("HIGH SCORES", 2, 130);
+      playSound(SOUND_CLICK); 
+      break;
+    case 3:
+      screen.fillRect(MENU_BAR_X, 170, MENU_BAR_W, 20, ILI9341_ORANGE); // Highlight REPLAY
+      screenDisplay("REPLAY", 2, 170);
+      playSound(SOUND_CLICK); 
       break;
   }
 }
@@ -183,21 +415,28 @@ void unhighlightMenuItem(int mode) {
   //FUNCTION TO ALLOW FOR USER INTUITIVENESS
   switch (mode) {
     case 1:
-      screen.fillRect(30, 90, 180, 20, ILI9341_BLACK);  // Clear START
-      screenDisplay("START", 90);
+      screen.fillRect(MENU_BAR_X, 90, MENU_BAR_W, 20, ILI9341_BLACK);  // Clear START
+      screenDisplay("START", 2, 90);
       break;
     case 2:
-      screen.fillRect(30, 130, 180, 20, ILI9341_BLACK); // Clear HIGHSCORES
-      screenDisplay("HIGH SCORES", 130);
+      screen.fillRect(MENU_BAR_X, 130, MENU_BAR_W, 20, ILI9341_BLACK); // Clear HIGHSCORES
+      screenDisplay("HIGH SCORES", 2, 130);
       break;      
+    case 3:
+      screen.fillRect(MENU_BAR_X, 170, MENU_BAR_W, 20, ILI9341_BLACK); // Clear REPLAY
+      screenDisplay("REPLAY", 2, 170);
+      break;
   }
 }
 
-int readAxis(int thisAxis) {
+int readAxis(uint8_t thisAxis) {
   // FUNCTION TO READ AND SCALE JOYSTICK INPUT
+  return scaleAxis(halReadAxis(thisAxis));
+}
 
-  int reading = analogRead(thisAxis);
-  reading = map(reading, 0, 1023, 0, range);
+int scaleAxis(int reading) {
+  // SCALE A RAW AXIS SAMPLE, READINGS NEAR THE CENTRE COUNT AS AT REST
+  reading = (long)reading * range / AXIS_MAX;
   int distance = reading - center;
   if (abs(distance) < threshold) {
     distance = 0;
@@ -206,481 +445,380 @@ int readAxis(int thisAxis) {
 }
 
 
-bool isBarrierOnSnake(int barrierX, int barrierY, SnakeSegment snake[], int snakeLength) {
-  for (int i = 0; i < snakeLength; i++) {
-    if (snake[i].x == barrierX && snake[i].y == barrierY) {
-      return true;  // Barrier overlaps with the snake's body
-    }
+void restoreBorder(int x, int y) {
+  // The last column and row of cells cover the right and bottom edges of the border
+  if (x + CELL_SIZE >= BORDER_X + BORDER_W) {
+    renderRect(BORDER_X + BORDER_W - 1, y, 1, CELL_SIZE, ILI9341_YELLOW);
+  }
+  if (y + CELL_SIZE >= BORDER_Y + BORDER_H) {
+    renderRect(x, BORDER_Y + BORDER_H - 1, CELL_SIZE, 1, ILI9341_YELLOW);
   }
-  return false;  // Barrier does not overlap with the snake's body
 }
 
-void generateBarrier(int &barrierX, int &barrierY, SnakeSegment snake[], int snakeLength) {
-  do {
-    barrierX = round(random(10, SCREEN_WIDTH - 10) * 0.1) * 10;
-    barrierY = round(random(30, screen.height() - 30) * 0.1) * 10;
-  } while (isBarrierOnSnake(barrierX, barrierY, snake, snakeLength));
+void eraseCell(Cell cell) {
+  // CLEAR A PLAYFIELD CELL, ONE FAST FILL
+  renderRect(cell.x(), cell.y(), CELL_SIZE, CELL_SIZE, ILI9341_BLACK);
+  restoreBorder(cell.x(), cell.y());
+  telemetryErase(cell);
+}
+
+void drawEntity(Cell cell, SpriteId sprite) {
+  // DRAW FOOD, BAD FOOD OR A BARRIER; SPRITES ARE OPAQUE SO THE BORDER IS PUT BACK
+  renderSprite(cell.x(), cell.y(), sprite);
+  restoreBorder(cell.x(), cell.y());
+  telemetryDraw(cell, sprite);
+}
+
+// How the game shows up on the device
+const GameView screenView = { eraseCell, drawEntity, playSound, updateScore };
+
+ReplayReader replayReader;  // feeds the turns of lastReplay during playback
+
+PlayMode playMode;           // what the play screen runs
+bool paused;                 // variable to show if game has been paused
+bool fast;                   // playback runs as fast as it can draw
+uint16_t foodMissedShown;    // foods timed out, as far as the countdown knows
+
+// Independent cadences for input, snake moves and redraws
+Cadence inputCadence;
+Cadence moveCadence;
+Cadence renderCadence;
+
+void playReplay() {
+  //WATCH THE LAST GAME AGAIN, MOVE FOR MOVE
+  if (!replayOpen(replayReader, lastReplay.bytes, lastReplay.length)) {
+    screenGo(SCREEN_NO_REPLAY);
+    return;
+  }
+  startPlay(PLAY_REPLAY);
 }
 
-void play() {
-  //MAIN GAMEPLAY HAPPENS HERE
+void startPlay(PlayMode mode) {
+  playMode = mode;
+  screenGo(SCREEN_PLAY);
+}
 
+void playEnter() {
+  //SET UP A GAME ON THE CLEARED SCREEN; playUpdate() RUNS IT
   // Setting up the screen
-  screen.fillScreen(ILI9341_BLACK);  // Clear the screen for the game
-  screen.drawRect(0,30,240,260,ILI9341_YELLOW);
-  
-  // Initialize the snake with one segment
-  SnakeSegment snake[MAX_SNAKE_LENGTH];
-  int snakeLength = 1;  // Start with one segment
-  snake[0].x = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;  // Adjusted to avoid edges
-  snake[0].y = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10;  // Adjusted to avoid edges
-  
-  bool gameRunning = true;        // variable to show if game is running/over
-  bool paused = true;             // variable to show if game has been paused
-  unsigned long lastMoveTime = 0; 
-  unsigned long moveDelay = 200;  // Control snake speed
-  unsigned short points = 0;
-  unsigned short level = 1;
-  char lastMove = 'r';  // Initial direction (right)
-
-  // Initial food position
-  int foodX = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;  // x coordinate of the food
-  int foodY = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10; // y coordinate of the food
-
-  int barrierX; // variable to store the x coordinate of the barrier
-  int barrierY; // variable to store the y coordinate of the barrier
-
-  // multiple bad foods can be present - using an array for bad foods
-  unsigned int badfoodX[MAX_BAD_FOOD];  // variable to store the x coordinate of the bad food(s)
-  unsigned int badfoodY[MAX_BAD_FOOD];  // variable to store the y coordinate of the bad food(s)
-  int currentBadFoodCount = 0;
-  
-  bool foodEaten = false; // variable to identify if the snake has consumed the food on the screen
+  screen.drawRect(BORDER_X,BORDER_Y,BORDER_W,BORDER_H,ILI9341_YELLOW);
+  hudReset();
+  boardShown = true;
+  playTimers.reset(halMillis());
+  playTimers.schedule(TIMER_COUNTDOWN, halMillis());
+
+  uint32_t seed = playMode == PLAY_REPLAY ? replayReader.seed : gameSeed++;
+  telemetryBegin(game, seed, playMode);
+  gameBegin(game, seed, &screenView);
+  if (playMode == PLAY_GAME) replayStart(lastReplay, seed);
+  if (playMode == PLAY_DEMO) autopilotBegin(autopilot);
+  renderFlush();
+  updateScore(game.points[0], game.level);
+  telemetryTick();
+
+  paused = false;
+  fast = false;
+  foodMissedShown = 0;
+  uint16_t now = schedulerNow();
+  inputCadence.start(INPUT_PERIOD, now);
+  moveCadence.start(game.levelParams.tickPeriod, now);
+  renderCadence.start(RENDER_PERIOD, now);
+  if (playMode == PLAY_GAME) playSound(SOUND_RESUME);
+}
 
-  while (gameRunning) {
-    unsigned long currentTime = millis();
+void pauseGame(bool pause) {
+  //SHOW OR TAKE DOWN THE PAUSE MESSAGE
+  paused = pause;
+  renderFlush();
+  if (paused) {
+    screen.setCursor(PAUSE_X, PAUSE_Y);
+    screen.setTextColor(ILI9341_YELLOW);
+    screen.setTextSize(2);
+    screen.print(F("Game Paused!"));
+    playSound(SOUND_PAUSE);
+    return;
+  }
+  playSound(SOUND_RESUME);
+  screen.fillRect(PAUSE_X, PAUSE_Y, PAUSE_W, 20, ILI9341_BLACK);
+
+  // Time spent paused must not turn into a burst of catch-up moves
+  uint16_t now = schedulerNow();
+  inputCadence.resync(now);
+  moveCadence.resync(now);
+  renderCadence.resync(now);
+}
 
-    // Handle pause/resume toggle if button is pressed
-    if (buttonPressed) {
-      playSound("GamePauseReleaseMusic");
-      paused = !paused;
-      buttonPressed = false;
-      delay(200);  // Debounce delay
+Rest playUpdate() {
+  //MAIN GAMEPLAY HAPPENS HERE, WHATEVER IS DUE ON EACH PASS
+  bool playback = playMode == PLAY_REPLAY;
+  bool demo = playMode == PLAY_DEMO;
+
+  // The button pauses a game, fast-forwards a replay and ends a demo
+  if (takePress()) {
+    if (demo) {
+      renderFlush();
+      screenGo(SCREEN_MENU);
+      return REST_BUSY;
     }
-
-    // If paused, display pause message and skip game updates
-    if (paused) {
-      screen.setCursor(50, 140);
-      screen.setTextColor(ILI9341_YELLOW);
-      screen.setTextSize(2);
-      screen.print("Game Paused!");
-      
-      playSound("GamePauseMusic");
-      while (!buttonPressed);
-      buttonPressed = false;
-      delay(200);  // Debounce delay
-      screen.fillRect(50, 140, 140, 20, ILI9341_BLACK);
-    } 
-
-    // Move the snake based on joystick input
-    xReading = readAxis(xAxis);
-    yReading = readAxis(yAxis);
-
-    // Make the snake move without going in reverse direction 
-    if (abs(xReading) > abs(yReading)) {
-      if (xReading < 0 && lastMove != 'l') lastMove = 'r';
-      else if (xReading > 0 && lastMove != 'r') lastMove = 'l';
-    } else if (abs(yReading) > abs(xReading)) {
-      if (yReading < 0 && lastMove != 'u') lastMove = 'd';
-      else if (yReading > 0 && lastMove != 'd') lastMove = 'u';
+    if (playback) {
+      fast = !fast;
+      moveCadence.resync(schedulerNow());
+    } else {
+      pauseGame(!paused);
     }
+  }
 
-    // Increase speed with level progression
-    if (level >= 5){
-    moveDelay = 200 * pow(0.8, level - 4);
+  // If paused, skip game updates until the button is pressed again
+  if (paused) return REST_SLEEP;
+
+  uint16_t now = schedulerNow();
+
+  if (inputCadence.due(now)) {
+    // Move the snake based on joystick input: every sample taken since the
+    // last look can queue a turn, so a quick flick between moves still counts
+    PROFILE(PROBE_INPUT);
+    if (remoteMove && !playback) {
+      if (demo) {
+        remoteMove = 0;
+        renderFlush();
+        screenGo(SCREEN_MENU);
+        return REST_BUSY;
+      }
+      gameSteer(game, remoteMove);
     }
-    
-    // Move the snake after delay
-    if (currentTime - lastMoveTime >= moveDelay) {
-      // Clear the last segment of the snake
-      screen.fillRect(snake[snakeLength - 1].x, snake[snakeLength - 1].y, 10, 10, ILI9341_BLACK);
-
-      // Move the body segments
-      for (int i = snakeLength - 1; i > 0; i--) {
-        snake[i] = snake[i - 1];  // Move each segment to the position of the previous one
+    remoteMove = 0;
+    JoystickSample sample;
+    while (halNextJoystickSample(sample)) {
+      if (playback) continue;  // the replay steers
+      xReading = scaleAxis(sample.x);
+      yReading = scaleAxis(sample.y);
+      if (demo) {
+        if (xReading == 0 && yReading == 0) continue;
+        renderFlush();
+        screenGo(SCREEN_MENU);  // the player wants the controls back
+        return REST_BUSY;
       }
 
-      // Move the head of the snake based on direction and continue through the walls
-      switch (lastMove) {
-        case 'r':
-          snake[0].x += 10;
-          if (snake[0].x > SCREEN_WIDTH - X_BOUNDARY) snake[0].x = X_BOUNDARY;
-          break;
-        case 'l':
-          snake[0].x -= 10;
-          if (snake[0].x < X_BOUNDARY) snake[0].x = SCREEN_WIDTH - X_BOUNDARY;
-          break;
-        case 'u':
-          snake[0].y -= 10;
-          if (snake[0].y < Y_BOUNDARY) snake[0].y = screen.height() - Y_BOUNDARY;
-          break;
-        case 'd':
-          snake[0].y += 10;
-          if (snake[0].y > screen.height() - Y_BOUNDARY) snake[0].y = Y_BOUNDARY;
-          break;
+      if (abs(xReading) > abs(yReading)) {
+        gameSteer(game, xReading < 0 ? 'r' : 'l');
+      } else if (abs(yReading) > abs(xReading)) {
+        gameSteer(game, yReading < 0 ? 'd' : 'u');
       }
+    }
+  }
 
-      screen.drawRect(0,30,240,260,ILI9341_YELLOW);
-      
-      // Draw the new head of the snake
-      screen.fillRect(snake[0].x, snake[0].y, 10, 10, ILI9341_GREEN);
-
-      lastMoveTime = currentTime;  // Update the last move time
-
-      // Check if the snake eats the food
-      if (snake[0].x == foodX && snake[0].y == foodY) {
-        playSound("playFoodEatenSong");
-        points++;
-        level = points / 2 + 1;
-        updateScore(points, level);
-        if (snakeLength < MAX_SNAKE_LENGTH) {
-          snakeLength++;  // Grow the snake
-        }
-
-        // Clear old food and generate new food
-        screen.fillRect(foodX, foodY, 10, 10, ILI9341_GREEN);
-        foodX = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;
-        foodY = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10;
+  // Move the snake once per tick period of the level, catching up on missed
+  // ticks; a fast-forwarded replay makes one move per pass instead
+  uint8_t steps = 0;
+  while (!(playback ? replayDone(replayReader, game) : game.over) && (fast ? steps == 0 : moveCadence.step(now))) {
+    if (++steps > MAX_CATCHUP_STEPS) {
+      moveCadence.resync(now);  // too far behind, drop the lag instead of freezing the loop
+      break;
+    }
+    if (playback) replaySteer(replayReader, game);
+    if (demo) {
+      autopilotThink(autopilot, game, AUTOPILOT_BUDGET);
+      char turn = autopilotSteer(autopilot, game);
+      if (turn) gameSteer(game, turn);
+    }
+    gameStep(game);
+    telemetryTick();
+    if (playMode == PLAY_GAME) replayRecord(lastReplay, game);
+    moveCadence.period = game.levelParams.tickPeriod;
+  }
 
-        for (int i = 0; i < snakeLength; i++){
-          if (foodX == snake[i].x && foodY == snake[i].y){
-            foodX = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;
-            foodY = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10;
-          } 
-        }
-        
-        screen.setCursor(barrierX, barrierY);
-        screen.setTextColor(ILI9341_BLACK);
-        screen.setTextSize(2);
-        screen.print("7");
-        
-        for (int i = 0; i < currentBadFoodCount; i++) {
-            screen.fillCircle(static_cast<int16_t>(badfoodX[i] + 5), static_cast<int16_t>(badfoodY[i] + 5), 4, ILI9341_BLACK);
-        }
+  // A replay also stops once it runs past the end of the recorded game
+  if (playback && replayDone(replayReader, game)) {
+    renderFlush();
+    screenGo(SCREEN_REPLAY_END);
+    return REST_BUSY;
+  }
 
-        foodEaten = true;
-        foodSpawnTime = millis();  // Reset the spawn time
-
-        if (level >= 2){
-          // Introducing the barrier at level 2
-          
-          generateBarrier(barrierX, barrierY, snake, snakeLength);
-          if ((abs(foodX - barrierX) <= 30) && (abs(foodY - barrierY) <= 30)){
-            // Ensuring there is a comfortable space between the food and the barrier
-            barrierX += 40;
-            barrierY += 40;
-          }
-
-          if (((snake[0].x >= 100) && (snake[0].x <= 140)) && ((snake[0].y >= 140) && (snake[0].y <= 180))){
-            // placing the barrier at a random corner if the snake eats food near the center of the screen
-            unsigned int corner = random(1,4);
-            switch (corner){
-              case 1:
-                barrierX = round(random(10, 40)*0.1)*10;
-                barrierY = round(random(35, 65)*0.1)*10;
-                break;
-              case 2:
-                barrierX = round(random(200, 230)*0.1)*10;
-                barrierY = round(random(35, 65)*0.1)*10;
-                break;
-              case 3:
-                barrierX = round(random(10, 40)*0.1)*10;
-                barrierY = round(random(230, 260)*0.1)*10;
-                break;
-              case 4:
-                barrierX = round(random(200, 230)*0.1)*10;
-                barrierY = round(random(230, 260)*0.1)*10;
-                break;
-            }
-          }
-        }
+  if (game.over && demo) {
+    renderFlush();
+    screenGo(SCREEN_DEMO_OVER);
+    return REST_BUSY;
+  }
 
-        if (level >= 4) {
-          // Introducing bad food at level 4
-          currentBadFoodCount = level - 3;
-          if (currentBadFoodCount < MAX_BAD_FOOD) {
-            for (int i = 0; i < currentBadFoodCount; i++){
-              // Placing bad food once the food has been eaten
-              screen.fillCircle(badfoodX[i] + 5, badfoodY[i] + 5, 4, ILI9341_BLACK);
-              badfoodX[i] = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY) * 0.1) * 10;
-              badfoodY[i] = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY) * 0.1) * 10;
-              for (int j = 0; j < snakeLength; j++){
-                if (badfoodX[i] == snake[j].x && badfoodY[i] == snake[j].y){
-                  badfoodX[i] = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;
-                  badfoodY[i] = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10;
-                } 
-              }
-              screen.fillCircle(badfoodX[i] + 5, badfoodY[i] + 5, 4, ILI9341_RED);
-              playSound("redFoodDisplayRing");
-            }  
-          }
-        }
-      } else {
-        foodEaten = false;
-      }
+  if (game.over) {
+    renderFlush();
+    replayFinish(lastReplay, game);
+    replayStoreSave();
+    screenGo(SCREEN_GAME_OVER);  // a collision ended the game
+    return REST_BUSY;
+  }
 
-      if (!foodEaten) {
-        if (level < 2) {
-          // Placing normal food
-          screen.fillCircle(foodX + 5, foodY + 5, 4, ILI9341_ORANGE);
-        }
-        if (level >= 2){
-          // Placing normal food and barriers
-          screen.fillCircle(foodX + 5, foodY + 5, 4, ILI9341_ORANGE);
-          screen.setCursor(barrierX, barrierY);
-          screen.setTextColor(ILI9341_RED);
-          screen.setTextSize(2);
-          screen.print("7");
-        } 
-        if (level >= 3) {
-          // Introducing a count down timer at level 3
-          unsigned long currentTime =  millis();
-          unsigned int remainingTime;
-          if (foodVisible) {
-            screen.fillCircle(foodX + 5, foodY + 5, 4, ILI9341_ORANGE);
-            // Show countdown timer for disappearing food
-            remainingTime = (foodDisappearTime - (currentTime - foodSpawnTime)) / 1000;
-            if (currentTime - lastUpdateTime >= 1000) {
-              if (remainingTime > 0) {
-                displayCountdown(round(remainingTime));
-              } else {
-                displayCountdown(0);
-            }
-            lastUpdateTime = currentTime;  // Update the last update time
-            }
-            // Check if 5 seconds have passed and hide food if necessary
-            if (currentTime - foodSpawnTime >= foodDisappearTime) {
-                foodVisible = false;  // Food disappears
-                screen.fillCircle(foodX + 5, foodY + 5, 4, ILI9341_BLACK);  // Hide food
-                displayCountdown(0);
-            }
-          }
-
-          if (!foodVisible) {
-            // Placing new food
-            foodX = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY) * 0.1) * 10;
-            foodY = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY) * 0.1) * 10;
-            for (int i = 0; i < snakeLength; i++){
-              if (foodX == snake[i].x && foodY == snake[i].y){
-                foodX = round(random(X_BOUNDARY, SCREEN_WIDTH - X_BOUNDARY)*0.1)*10;
-                foodY = round(random(Y_BOUNDARY, screen.height() - Y_BOUNDARY)*0.1)*10;
-              } 
-            }
-            foodVisible = true;  // Make the new food visible
-            foodSpawnTime = millis();  // Reset the spawn time
-          }
-        }
-      }
-      for (int i = 0; i < currentBadFoodCount; i++) {
-        // Checking if the snake has eaten bad food
-        if (snake[0].x == badfoodX[i] && snake[0].y == badfoodY[i]) {
-            points--;
-            playSound("redFoodEatingRing");
-            level = points / 2 + 1;
-            updateScore(points, level);
-            screen.fillRect(snake[snakeLength - 1].x, snake[snakeLength - 1].y, 10, 10, ILI9341_BLACK);
-            snakeLength--; // Reduce snake length
-        }
-      }
+  if (renderCadence.due(now)) {
+    // Food and barriers are drawn once when they appear, only timed food needs attention here
+    if (game.foodMissed != foodMissedShown) {
+      // Once the food has timed out it moves to a new place
+      displayCountdown(0);
+      foodMissedShown = game.foodMissed;
+      playTimers.schedule(TIMER_COUNTDOWN, halMillis() + COUNTDOWN_PERIOD);
     }
 
-    // Check if the snake's head collides with its body
-    for (int i = 3; i < snakeLength; i++) {  // Start from 2 to skip the head and quick turns
-        if (snake[0].x == snake[i].x && snake[0].y == snake[i].y) {
-            gameOver(points);  // Call the gameOver function if a collision is detected
-            gameRunning = false;
+    uint8_t timer;
+    while ((timer = playTimers.expire(halMillis())) != WHEEL_NONE) {
+      switch (timer) {
+        case TIMER_COUNTDOWN: {
+          // Count down timer for the food from level 3, in game time; below
+          // that it rests until updateScore() sees a level with timed food
+          if (game.levelParams.foodLifetime == 0) break;
+          unsigned long age = game.clock - game.foodSpawnTime;
+          unsigned int remainingTime = age < game.levelParams.foodLifetime ? (game.levelParams.foodLifetime - age) / 1000 : 0;
+          displayCountdown(remainingTime);
+          playTimers.schedule(TIMER_COUNTDOWN, halMillis() + COUNTDOWN_PERIOD);
+          break;
         }
+      }
     }
+  }
 
-    // Check if the snake has collided with the barrier
-    if (snake[0].x == barrierX && snake[0].y == barrierY){
-      gameOver(points);
-      gameRunning = false;
-    }
+  // Everything drawn this frame goes out in one SPI transaction
+  renderFlush();
+  return fast ? REST_BUSY : REST_IDLE;  // a fast-forward moves on every pass
+}
 
-    // Small delay to prevent excessive CPU usage
-    delay(50);
+void serialCommands() {
+  // DIAGNOSTICS OVER SERIAL: 'p' PROFILE REPORT, 'r' PROFILE RESET, 'g' GET THE LAST REPLAY,
+  // AND TELEMETRY FRAMES FROM A HOST THAT STEER OR PRESS THE BUTTON
+  int c = halSerialRead();
+  if (c < 0) return;
+  switch (telemetryReceive(c)) {
+    case REMOTE_STEER:
+      remoteMove = telemetryRemoteTurn();
+      return;
+    case REMOTE_BUTTON:
+      buttonPressed = true;
+      playSound(SOUND_CLICK);
+      return;
+    case REMOTE_NONE:
+      return;
+    case REMOTE_TEXT:
+      break;
+  }
+  switch (c) {
+    case 'p': profilerReport(); break;
+    case 'r': profilerReset(); break;
+    case 'g': replayStoreDump(); break;
   }
 }
 
 void joystickISR() {
   // FUNCTION TO HANDLE JOYSTICK MOVEMENTS AND BUTTON PRESS
-  if (digitalRead(mouseButton) == LOW) {
+  if (halButtonDown()) {
     buttonPressed = true;
-    playSound("clickSound"); 
+    playSound(SOUND_CLICK); 
   }
 }
 
 void updateScore(int points,int level){
   // FUNCTION TO UPDATE THE SCORE AND THE LEVEL ON THE SCREEN
-  screen.setCursor(80,300);
-  screen.fillRect(80,300,150,20,ILI9341_BLACK);
-  screen.setTextColor(ILI9341_WHITE);
-  screen.setTextSize(2);
-  screen.print("Score: ");
-  screen.print(points);
-  screen.setCursor(20,10);
-  screen.fillRect(20,10,150,20,ILI9341_BLACK);
-  screen.print("Level ");
-  screen.print(level);
+  // The labels stay on screen, only digits that changed are redrawn
+  hudSetScore(points);
+  hudSetLevel(level);
+  telemetryScore(points, level);
+
+  // A level with timed food shows its countdown straight away
+  if (game.levelParams.foodLifetime > 0 && !playTimers.pending(TIMER_COUNTDOWN)) {
+    playTimers.schedule(TIMER_COUNTDOWN, halMillis());
+  }
 }
 
-void gameOver(int points){
-  // FUNCTION TO RUN THE GAME OVER SEQUENCE
-  screen.fillRect(10,10,220,300,ILI9341_WHITE);
+void gameOverEnter(){
+  // FUNCTION TO RUN THE GAME OVER SEQUENCE, THE BOARD STAYS UP AROUND IT
+  int points = game.points[0];
+  screen.fillRect(PANEL_X,PANEL_Y,PANEL_W,PANEL_H,ILI9341_WHITE);
   screen.setCursor(50, 140);
   screen.setTextColor(ILI9341_RED);
   screen.setTextSize(3);
-  screen.print("GAME OVER!");
+  screen.print(F("GAME OVER!"));
   screen.setCursor(50,180);
   screen.setTextColor(ILI9341_BLACK);
-  screen.print("SCORE: ");
+  screen.print(F("SCORE: "));
   screen.print(points);
 
-  int highScore = readHighScore();
-  // Update the high score if applicable
-  if ((points > highScore)) {
+  // Enter the score on the leaderboard; it is saved in the background
+  if (leaderboardSubmit(points) == 0) {
     screen.setCursor(20, 80);
     screen.setTextSize(2);
-    screen.print("NEW HIGHSCORE!");
-    writeHighScore(points);
-    highScore = points;  // Update local high score variable
+    screen.print(F("NEW HIGHSCORE!"));
   }
-  delay(1000);
-  playSound("playGameOverSong");
-  highscore();
-  
-  
+  screenHold.start(GAME_OVER_HOLD, schedulerNow());
+}
+
+Rest gameOverUpdate() {
+  if (!screenHold.due(schedulerNow())) return REST_IDLE;
+  playSound(SOUND_GAME_OVER);
+  screenGo(SCREEN_SCORES);
+  return REST_BUSY;
+}
+
+void panelExit() {
+  screen.fillRect(PANEL_X, PANEL_Y, PANEL_W, PANEL_H, ILI9341_BLACK);
+}
+
+void replayEndEnter(){
+  // FUNCTION TO SHOW WHETHER PLAYBACK ENDED WHERE THE RECORDED GAME DID
+  bool matched = replayMatches(replayReader, game);
+  screen.fillRect(PANEL_X,PANEL_Y,PANEL_W,PANEL_H,ILI9341_WHITE);
+  screen.setTextColor(matched ? ILI9341_BLACK : ILI9341_RED);
+  if (matched) {
+    screenDisplay("REPLAY OK", 2, 140);
+  } else if (replayReader.verified) {
+    screenDisplay("REPLAY MISMATCH", 2, 140);
+  } else {
+    screenDisplay("REPLAY END", 2, 140);  // recording was cut short, nothing to check
+  }
+  playSound(SOUND_GAME_OVER);
+  screenHold.start(REPLAY_END_HOLD, schedulerNow());
+}
+
+void demoOverEnter() {
+  screenHold.start(DEMO_GAP, schedulerNow());
+}
+
+Rest demoOverUpdate() {
+  //LET THE AUTOPILOT PLAY GAME AFTER GAME UNTIL THE PLAYER TAKES OVER
+  if (!screenHold.due(schedulerNow())) return REST_IDLE;
+  startPlay(PLAY_DEMO);
+  return REST_BUSY;
 }
 
 void displayCountdown(unsigned int remainingTime) {
   // DISPLAYS THE COUNTDOWN TIMER ON THE SCREEN STARTING FROM LEVEL 3
-    screen.fillRect(120, 10, 80, 20, ILI9341_BLACK);  // Clear previous countdown
-    screen.setCursor(120, 10);
-    screen.setTextColor(ILI9341_WHITE);
-    screen.setTextSize(2);
     if (remainingTime > 0) {
-        screen.print("Food: ");
-        screen.print(remainingTime);
-        screen.print("s");
+      hudSetCountdown(remainingTime);
     }else {
-      screen.print("Missed!");
+      hudCountdownMissed();
     }
 }
 
-int readHighScore() {
-  // READ THE HIGHSCORE FROM THE EEPROM
-    int highScore ;
-    EEPROM.get(EEPROM_HIGH_SCORE_ADDRESS, highScore);
-    return highScore;
-}
-
-void writeHighScore(int highScore) {
-  // WRITE THE HIGHSCORE TO THE EEPROM
-    EEPROM.put(EEPROM_HIGH_SCORE_ADDRESS, highScore);
-}
-
-void highscore(){
+void scoresEnter(){
   // HIGHSCORE MODE FROM THE MENU 
-  screen.fillScreen(ILI9341_BLACK);
-  int highScore = readHighScore();
-  screen.fillScreen(ILI9341_BLACK);
-  screen.setCursor(50, 50);
+  screen.setCursor(SCORES_X, SCORES_Y);
   screen.setTextColor(ILI9341_WHITE);
   screen.setTextSize(2);
-  screen.print("High Score: ");
-  if (highScore < 0) {
-    highScore = 0;
+  screen.print(F("High Scores"));
+  for (uint8_t rank = 0; rank < LEADERBOARD_SIZE; rank++) {
+    screen.setCursor(SCORES_X, SCORES_Y + 40 + rank * 30);
+    screen.print(rank + 1);
+    screen.print(F(". "));
+    screen.print(leaderboardScore(rank));
   }
-  screen.print(highScore); 
-  delay(1500);  // Display high score for 3 seconds
-  screen.fillScreen(ILI9341_BLACK);
-  menu();
+  screenHold.start(SCORES_HOLD, schedulerNow());  // Display high score for 1.5 seconds
 }
 
+void scoresExit() {
+  screen.fillRect(SCORES_X, SCORES_Y, SCORES_W, SCORES_H, ILI9341_BLACK);
+}
 
-void displayBackButton() {
-  // BUTTON TO PRESS WHEN IN THE HIGHSCORE MENU
-  screen.fillRect(10, 300, 80, 20, ILI9341_BLUE);  // Draw the button
-  screen.setCursor(20, 305);
+void noReplayEnter() {
   screen.setTextColor(ILI9341_WHITE);
-  screen.setTextSize(2);
-  screen.print("BACK");
-  while (!buttonPressed);  // Wait for button press
-  delay(100);
-  buttonPressed = false;  // Reset the button press flag
-  screen.fillScreen(ILI9341_BLACK);
-  menu();  // Navigate back to the menu
-}
-
-void playSound(char sound[]) {
-  int hit;
-  if (strcmp(sound, "playFoodEatenSong") == 0) hit = 1;
-  else if (strcmp(sound, "redFoodDisplayRing") == 0) hit = 2;
-  else if (strcmp(sound, "gameStartingMelody") == 0) hit = 3;
-  else if (strcmp(sound, "playGameOverSong") == 0) hit = 4;
-  else if (strcmp(sound, "redFoodEatingRing") == 0) hit = 5;
-  else if (strcmp(sound, "gamePauseMusic") == 0) hit = 6;
-  else if (strcmp(sound, "GamePauseReleaseMusic") == 0) hit = 7;
-  else if (strcmp(sound, "clickSound") == 0) hit = 8;
-
-  switch (hit) {
-    case 1:
-      tone(BUZZER, 523, 200);
-      delay(50);
-      tone(BUZZER, 784, 200);
-      delay(50);
-      break;
-    case 2:
-      tone(BUZZER, 10, 100);
-      break;
-    case 3: {
-      int melody[] = {900, 800, 700, 600, 500, 400, 300, 200, 100};
-      for (int i = 0; i < 9; i++) {
-        tone(BUZZER, melody[i]);
-        delay(50);
-        noTone(BUZZER);
-        delay(50);
-      }
-      break;
-    }
-    case 4:
-      tone(BUZZER, 523, 200);
-      delay(50);
-      tone(BUZZER, 392, 200);
-      delay(50);
-      tone(BUZZER, 330, 200);
-      delay(50);
-      tone(BUZZER, 293, 200);
-      delay(50);
-      tone(BUZZER, 261.6, 400);
-      delay(50);
-      break;
-    case 5:
-      tone(BUZZER, 6000, 400);
-      delay(50);
-      break;
-    case 6:
-      tone(BUZZER, 9000, 10);
-      break;
-    case 7:
-      tone(BUZZER, 10000, 10);
-      break;
-    case 8:
-      tone(BUZZER, 1000, 10);
-      break;
-    default:
-      // Optionally handle if no valid sound string was passed
-      break;
-  }
-}
\ No newline at end of file
+  screenDisplay("NO REPLAY", 2, NOTICE_Y);
+  screenHold.start(NO_REPLAY_HOLD, schedulerNow());
+}
+
+void noReplayExit() {
+  screen.fillRect(CENTERED_X("NO REPLAY", 2), NOTICE_Y, (sizeof("NO REPLAY") - 1) * 12, 16, ILI9341_BLACK);
+}
@@ -0,0 +1,86 @@
+#include "profiler.h"
+
+#ifdef SNAKE_PROFILE
+
+#include <string.h>
+#include "hal.h"
+
+struct ProbeStats {
+  uint32_t calls;
+  uint32_t total;  // cycles, halved together with calls before it would overflow
+  uint32_t min;
+  uint32_t max;
+  uint16_t buckets[PROFILE_BUCKETS];
+};
+
+static ProbeStats probes[PROBE_COUNT];
+
+static const char probeNames[PROBE_COUNT][8] PROGMEM = {
+  "input", "step", "spawn", "queue", "flush", "hud", "audio", "pilot", "wake"
+};
+
+uint32_t profilerNow() {
+  return halCycles();
+}
+
+void profilerRecord(ProbeId probe, uint32_t cycles) {
+  // Probes also run in interrupts, keep them out while a record is half written
+  uint8_t bucket = 0;
+  for (uint32_t limit = 64; bucket < PROFILE_BUCKETS - 1 && cycles >= limit; limit <<= 2) bucket++;
+
+  uint8_t state = halLock();
+  ProbeStats &stats = probes[probe];
+  if (stats.total + cycles < stats.total) {
+    stats.total >>= 1;
+    stats.calls >>= 1;
+  }
+  stats.total += cycles;
+  stats.calls++;
+  if (stats.calls == 1 || cycles < stats.min) stats.min = cycles;
+  if (cycles > stats.max) stats.max = cycles;
+  if (stats.buckets[bucket] != 0xFFFF) stats.buckets[bucket]++;
+  halUnlock(state);
+}
+
+void profilerReset() {
+  uint8_t state = halLock();
+  for (uint8_t i = 0; i < PROBE_COUNT; i++) probes[i] = ProbeStats();
+  halUnlock(state);
+}
+
+static void printField(uint32_t value, uint8_t width) {
+  // Right aligned decimal, no printf
+  char text[12];
+  char *end = text + sizeof(text) - 1;
+  char *digit = end;
+  *end = 0;
+  do {
+    *--digit = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  while (end - digit < width && digit > text) *--digit = ' ';
+  halSerialWrite(digit);
+}
+
+void profilerReport() {
+  // ONE LINE PER PROBE, TIMES IN CPU CYCLES
+  halSerialWrite(F("probe      calls     min     avg     max  <64 <256  <1k  <4k <16k <64k<256k more\n"));
+  for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+    uint8_t state = halLock();
+    ProbeStats stats = probes[i];
+    halUnlock(state);
+
+    char name[8];
+    memcpy_P(name, probeNames[i], sizeof(name));
+    halSerialWrite(name);
+    for (uint8_t pad = strlen(name); pad < 6; pad++) halSerialWrite(F(" "));
+    printField(stats.calls, 10);
+    printField(stats.min, 8);
+    printField(stats.calls ? stats.total / stats.calls : 0, 8);
+    printField(stats.max, 8);
+    for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) printField(stats.buckets[b], 5);
+    halSerialWrite(F("\n"));
+  }
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "render.h"
+#include "board.h"
+#include "profiler.h"
+
+struct RenderItem {
+  int16_t x, y, w, h;
+  uint16_t color;  // fill colour, or the SpriteId of a sprite
+  RenderKind kind;
+};
+
+static Display *tft;
+static RenderItem queue[RENDER_QUEUE_SIZE];
+static uint8_t queued = 0;
+
+static bool overlaps(const RenderItem &a, int16_t x, int16_t y, int16_t w, int16_t h) {
+  return a.x < x + w && x < a.x + a.w && a.y < y + h && y < a.y + a.h;
+}
+
+// Grow a queued rect by a touching rect of the same colour when the union is still a rect
+static bool tryMerge(RenderItem &a, int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (a.y == y && a.h == h && (a.x + a.w == x || x + w == a.x)) {
+    if (x < a.x) a.x = x;
+    a.w += w;
+    return true;
+  }
+  if (a.x == x && a.w == w && (a.y + a.h == y || y + h == a.y)) {
+    if (y < a.y) a.y = y;
+    a.h += h;
+    return true;
+  }
+  return a.x == x && a.y == y && a.w == w && a.h == h;
+}
+
+static void enqueue(RenderKind kind, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (kind == RENDER_RECT) {
+    // Walk back from the newest item; an overlapping item of another kind or colour
+    // has to stay drawn before this one, so nothing older than it can absorb the rect
+    for (int8_t i = queued - 1; i >= 0; i--) {
+      RenderItem &item = queue[i];
+      bool sameFill = item.kind == RENDER_RECT && item.color == color;
+      if (sameFill && tryMerge(item, x, y, w, h)) return;
+      if (overlaps(item, x, y, w, h)) break;
+    }
+  }
+  if (queued == RENDER_QUEUE_SIZE) renderFlush();
+  RenderItem &item = queue[queued++];
+  item.x = x;
+  item.y = y;
+  item.w = w;
+  item.h = h;
+  item.color = color;
+  item.kind = kind;
+}
+
+void renderBegin(Display &display) {
+  tft = &display;
+  queued = 0;
+}
+
+void renderRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  PROFILE(PROBE_RENDER_QUEUE);
+  enqueue(RENDER_RECT, x, y, w, h, color);
+}
+
+void renderSprite(int16_t x, int16_t y, SpriteId sprite) {
+  PROFILE(PROBE_RENDER_QUEUE);
+  enqueue(RENDER_SPRITE, x, y, CELL_SIZE, CELL_SIZE, sprite);
+}
+
+static void blitSprite(int16_t x, int16_t y, SpriteId sprite) {
+  // ONE ADDRESS WINDOW AND ONE BURST OF CELL_SIZE x CELL_SIZE PIXELS
+  uint16_t palette[4];
+  uint16_t line[CELL_SIZE];
+  spritePalette(sprite, palette);
+  tft->setAddrWindow(x, y, CELL_SIZE, CELL_SIZE);
+  for (uint8_t row = 0; row < CELL_SIZE; row++) {
+    spriteRow(sprite, row, palette, line);
+    tft->writePixels(line, CELL_SIZE);
+  }
+}
+
+void renderFlush() {
+  // SEND EVERYTHING QUEUED THIS FRAME IN A SINGLE SPI TRANSACTION
+  if (queued == 0) {
+    halFrameEnd();
+    return;
+  }
+  PROFILE(PROBE_RENDER_FLUSH);
+  tft->startWrite();
+  for (uint8_t i = 0; i < queued; i++) {
+    const RenderItem &item = queue[i];
+    switch (item.kind) {
+      case RENDER_RECT:
+        tft->writeFillRect(item.x, item.y, item.w, item.h, item.color);
+        break;
+      case RENDER_SPRITE:
+        blitSprite(item.x, item.y, (SpriteId)item.color);
+        break;
+    }
+  }
+  tft->endWrite();
+  queued = 0;
+  halFrameEnd();
+}
@@ -0,0 +1,148 @@
+#include "replay.h"
+
+#define DELTA_LONG 62  // a varint with the rest of the delta follows
+#define END_MARKER 63
+#define END_RESERVE 8  // end marker, varint move count, score
+
+//=================================================================
+// Recording
+
+static bool put(Replay &replay, uint8_t byte) {
+  if (replay.length == REPLAY_CAPACITY) return false;
+  replay.bytes[replay.length++] = byte;
+  return true;
+}
+
+static void putVarint(Replay &replay, uint32_t value) {
+  while (value >= 0x80) {
+    put(replay, (value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  put(replay, value);
+}
+
+static uint8_t varintSize(uint32_t value) {
+  uint8_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+void replayStart(Replay &replay, uint32_t seed) {
+  replay.length = 0;
+  replay.truncated = false;
+  replay.nextTick = 0;
+  replay.heading = 'r';  // every game starts heading right
+  put(replay, 'S');
+  put(replay, 'R');
+  put(replay, REPLAY_VERSION);
+  for (uint8_t i = 0; i < 4; i++) put(replay, seed >> (8 * i));
+}
+
+void replayRecord(Replay &replay, const Game &game) {
+  if (replay.truncated || game.snakes.direction[0] == replay.heading) return;
+
+  // The move just made is number game.ticks - 1, counting from 0
+  uint32_t tick = game.ticks - 1;
+  uint32_t delta = tick - replay.nextTick;
+  uint8_t size = delta < DELTA_LONG ? 1 : 1 + varintSize(delta - DELTA_LONG);
+  if (replay.length + size + END_RESERVE > REPLAY_CAPACITY) {
+    replay.truncated = true;
+    return;
+  }
+
+  uint8_t code = SnakeSet::directionCode(game.snakes.direction[0]) << 6;
+  if (delta < DELTA_LONG) {
+    put(replay, code | delta);
+  } else {
+    put(replay, code | DELTA_LONG);
+    putVarint(replay, delta - DELTA_LONG);
+  }
+  replay.nextTick = tick + 1;
+  replay.heading = game.snakes.direction[0];
+}
+
+void replayFinish(Replay &replay, const Game &game) {
+  if (replay.truncated) return;
+  put(replay, END_MARKER);
+  putVarint(replay, game.ticks);
+  put(replay, game.points[0]);
+  put(replay, game.points[0] >> 8);
+}
+
+//=================================================================
+// Playback
+
+static bool get(ReplayReader &reader, uint8_t &byte) {
+  if (reader.position >= reader.length) return false;
+  byte = reader.bytes[reader.position++];
+  return true;
+}
+
+static bool getVarint(ReplayReader &reader, uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 32; shift += 7) {
+    uint8_t byte;
+    if (!get(reader, byte)) return false;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// Read the next turn, or the end marker
+static void readTurn(ReplayReader &reader) {
+  reader.nextHeading = 0;
+  uint8_t byte;
+  if (!get(reader, byte)) return;
+
+  uint8_t field = byte & 0x3F;
+  if (field == END_MARKER) {
+    uint8_t low = 0, high = 0;
+    reader.verified = getVarint(reader, reader.finalTicks) && get(reader, low) && get(reader, high);
+    reader.finalPoints = low | (high << 8);
+    return;
+  }
+
+  uint32_t delta = field;
+  if (field == DELTA_LONG) {
+    uint32_t rest;
+    if (!getVarint(reader, rest)) return;
+    delta += rest;
+  }
+  reader.nextTick += delta;
+  reader.nextHeading = "rlud"[byte >> 6];
+}
+
+bool replayOpen(ReplayReader &reader, const uint8_t *bytes, uint16_t length) {
+  if (length < REPLAY_HEADER || bytes[0] != 'S' || bytes[1] != 'R' || bytes[2] != REPLAY_VERSION) return false;
+  reader.bytes = bytes;
+  reader.length = length;
+  reader.position = REPLAY_HEADER;
+  reader.seed = 0;
+  for (uint8_t i = 0; i < 4; i++) reader.seed |= (uint32_t)bytes[3 + i] << (8 * i);
+  reader.nextTick = 0;
+  reader.verified = false;
+  reader.finalTicks = 0;
+  reader.finalPoints = 0;
+  readTurn(reader);
+  return true;
+}
+
+void replaySteer(ReplayReader &reader, Game &game) {
+  // The move about to be made is number game.ticks
+  if (!reader.nextHeading || reader.nextTick != game.ticks) return;
+  gameSteer(game, reader.nextHeading);
+  reader.nextTick++;
+  readTurn(reader);
+}
+
+bool replayDone(const ReplayReader &reader, const Game &game) {
+  return game.over || (reader.verified && game.ticks >= reader.finalTicks);
+}
+
+bool replayMatches(const ReplayReader &reader, const Game &game) {
+  return reader.verified && game.over && game.ticks == reader.finalTicks && game.points[0] == reader.finalPoints;
+}
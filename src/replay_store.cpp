@@ -0,0 +1,77 @@
+#include "replay_store.h"
+#include "hal.h"
+#include "leaderboard.h"
+
+#define DATA_ADDRESS (REPLAY_STORE_ADDRESS + 2)
+#define NO_SAVE 0xFFFF
+
+static_assert(REPLAY_STORE_ADDRESS >= LEADERBOARD_ADDRESS + LEADERBOARD_SLOTS * LEADERBOARD_SLOT, "replay must not overlap the leaderboard");
+static_assert(DATA_ADDRESS + REPLAY_CAPACITY <= HAL_EEPROM_SIZE, "replay must fit the EEPROM");
+
+Replay lastReplay;
+
+// Save progress: NO_SAVE when idle, otherwise the next byte to write,
+// with the length first (cleared) and last (the real one)
+static uint16_t saved = NO_SAVE;
+static bool lengthCleared;
+
+void replayStoreBegin() {
+  // TAKE THE SAVED REPLAY ONLY WHEN ITS HEADER CHECKS OUT
+  uint16_t length = halEepromRead(REPLAY_STORE_ADDRESS) | (halEepromRead(REPLAY_STORE_ADDRESS + 1) << 8);
+  lastReplay.length = 0;
+  lastReplay.truncated = false;
+  if (length < REPLAY_HEADER || length > REPLAY_CAPACITY) return;
+  for (uint16_t i = 0; i < length; i++) lastReplay.bytes[i] = halEepromRead(DATA_ADDRESS + i);
+  ReplayReader reader;
+  if (replayOpen(reader, lastReplay.bytes, length)) lastReplay.length = length;
+}
+
+void replayStoreSave() {
+  saved = 0;
+  lengthCleared = false;
+  replayStorePoll();
+}
+
+void replayStorePoll() {
+  if (saved == NO_SAVE || halEepromBusy()) return;
+
+  if (!lengthCleared) {
+    static const uint8_t cleared[2] = { 0, 0 };
+    lengthCleared = halEepromWrite(REPLAY_STORE_ADDRESS, cleared, 2);
+    return;
+  }
+
+  if (saved < lastReplay.length) {
+    uint8_t chunk = lastReplay.length - saved < HAL_EEPROM_WRITE_MAX ? lastReplay.length - saved : HAL_EEPROM_WRITE_MAX;
+    if (halEepromWrite(DATA_ADDRESS + saved, lastReplay.bytes + saved, chunk)) saved += chunk;
+    return;
+  }
+
+  const uint8_t length[2] = { (uint8_t)lastReplay.length, (uint8_t)(lastReplay.length >> 8) };
+  if (halEepromWrite(REPLAY_STORE_ADDRESS, length, 2)) saved = NO_SAVE;
+}
+
+bool replayStoreBusy() {
+  return saved != NO_SAVE;
+}
+
+static char hexDigit(uint8_t value) {
+  return value < 10 ? '0' + value : 'a' + value - 10;
+}
+
+void replayStoreDump() {
+  // ONE LINE OF HEX, A FEW BYTES PER WRITE
+  halSerialWrite(F("replay "));
+  char text[17];
+  uint8_t used = 0;
+  for (uint16_t i = 0; i < lastReplay.length; i++) {
+    text[used++] = hexDigit(lastReplay.bytes[i] >> 4);
+    text[used++] = hexDigit(lastReplay.bytes[i] & 15);
+    if (used == sizeof(text) - 1 || i == lastReplay.length - 1) {
+      text[used] = 0;
+      halSerialWrite(text);
+      used = 0;
+    }
+  }
+  halSerialWrite(F("\n"));
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include "sim.h"
+
+//=================================================================
+// Nothing to show or hear
+
+static void eraseNothing(Cell) {}
+static void drawNothing(Cell, SpriteId) {}
+static void playNothing(SoundId) {}
+static void showNothing(int, int) {}
+
+static const GameView headlessView = { eraseNothing, drawNothing, playNothing, showNothing };
+
+//=================================================================
+// Greedy steering
+
+static bool blockedCell(const Game &game, uint8_t snake, char direction) {
+  Cell next = game.snakes.head[snake];
+  stepCell(next, direction);
+  return game.bodyGrid.test(next)
+      || game.barrierGrid.test(next)
+      || game.badFoodGrid.test(next);
+}
+
+static char reverse(char direction) {
+  return direction == 'r' ? 'l' : direction == 'l' ? 'r' : direction == 'u' ? 'd' : 'u';
+}
+
+char simChase(const Game &game, uint8_t snake) {
+  // Head for the food along the longer gap first, then any free cell
+  char heading = game.snakes.direction[snake];
+  int dx = game.food.col - game.snakes.head[snake].col;
+  int dy = game.food.row - game.snakes.head[snake].row;
+  char major = dx > 0 ? 'r' : 'l';
+  char minor = dy > 0 ? 'd' : 'u';
+  if (abs(dy) > abs(dx)) {
+    char swap = major;
+    major = minor;
+    minor = swap;
+  }
+  const char order[4] = { major, minor, reverse(minor), reverse(major) };
+  for (uint8_t i = 0; i < 4; i++) {
+    if (order[i] != reverse(heading) && !blockedCell(game, snake, order[i])) return order[i];
+  }
+  return 0;
+}
+
+//=================================================================
+
+void simBegin(Sim &sim, uint32_t seed, uint8_t snakes) {
+  sim.seed = seed;
+  sim.snakes = snakes;
+  sim.stats = SimStats();
+  sim.stats.checksum = 2166136261UL;  // FNV-1a offset basis
+  simNewGame(sim);
+}
+
+void simNewGame(Sim &sim) {
+  gameBegin(sim.game, sim.seed++, &headlessView, sim.snakes);
+  sim.stats.games++;
+  sim.stats.peakLevel = sim.game.level;
+  sim.stats.scoreWrapped = false;
+}
+
+static void fold(uint32_t &checksum, uint16_t value) {
+  checksum = (checksum ^ value) * 16777619UL;  // FNV-1a prime
+}
+
+bool simTick(Sim &sim, char direction) {
+  Game &game = sim.game;
+  SimStats &stats = sim.stats;
+
+  if (direction) gameSteer(game, direction);
+
+  // Same test the engine makes, taken before the move changes the food
+  const SnakeSet &snakes = game.snakes;
+  Cell next = snakes.head[0];
+  stepCell(next, game.turnCount[0] ? game.turns[0][0] : snakes.direction[0]);
+  if (next == game.food) stats.foodEaten++;
+
+  unsigned short points = game.points[0];
+  gameStep(game);
+  if (points == 0 && game.points[0] == 0xFFFF) stats.scoreWrapped = true;
+  if (game.badFoodGrid.test(snakes.head[0])) stats.badFoodEaten++;
+
+  stats.ticks++;
+  if (snakes.length[0] > stats.maxLength) stats.maxLength = snakes.length[0];
+  // The wrapped score and the level it drags along are not real progress
+  if (!stats.scoreWrapped) {
+    if (game.points[0] > stats.bestScore) stats.bestScore = game.points[0];
+    if (game.level > stats.peakLevel) stats.peakLevel = game.level;
+  }
+  fold(stats.checksum, snakes.head[0].x());  // pixels, as sums were taken before cells
+  fold(stats.checksum, snakes.head[0].y());
+  fold(stats.checksum, game.points[0]);
+  return !game.over;
+}
+
+void simRun(Sim &sim, SimScript &script, uint32_t ticks) {
+  for (uint32_t i = 0; i < ticks; i++) {
+    if (!simTick(sim, script.next())) simNewGame(sim);
+  }
+}
+
+bool simReplay(Sim &sim, ReplayReader &reader, uint32_t ticks) {
+  sim.seed = reader.seed;
+  sim.snakes = 1;
+  simNewGame(sim);
+  for (uint32_t i = 0; i < ticks && !replayDone(reader, sim.game); i++) {
+    replaySteer(reader, sim.game);
+    simTick(sim, 0);
+  }
+  return replayMatches(reader, sim.game);
+}
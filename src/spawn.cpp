@@ -0,0 +1,31 @@
+#include "spawn.h"
+
+int16_t pickFreeCell(const OccupancyGrid &blocked, Rng &rng) {
+  // PICK A UNIFORMLY RANDOM FREE CELL IN BOUNDED TIME
+  const uint8_t lastBits = GRID_CELLS % 8 ? (1 << (GRID_CELLS % 8)) - 1 : 0xFF;
+  const GridByte byteCount = sizeof(blocked.bits);
+
+  uint16_t freeCells = GRID_CELLS - blocked.count();
+  if (freeCells == 0) return -1;
+
+  uint16_t rank = rng.below(freeCells);
+  for (GridByte i = 0; i < byteCount; i++) {
+    uint8_t freeBits = ~blocked.bits[i];
+    if (i == byteCount - 1) freeBits &= lastBits;  // ignore padding past the last cell
+    uint8_t inByte = __builtin_popcount(freeBits);
+    if (rank < inByte) {
+      // The wanted cell is in this byte, step over the lower free bits
+      while (rank--) freeBits &= freeBits - 1;
+      return i * 8 + __builtin_ctz(freeBits);
+    }
+    rank -= inByte;
+  }
+  return -1;
+}
+
+bool placeInFreeCell(const OccupancyGrid &blocked, Rng &rng, Cell &cell) {
+  int16_t index = pickFreeCell(blocked, rng);
+  if (index < 0) return false;
+  cell = cellAt(index);
+  return true;
+}
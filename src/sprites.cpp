@@ -0,0 +1,82 @@
+#include "sprites.h"
+#include "hal.h"
+
+//=================================================================
+// The art is written out as text below and packed into 2-bit pixels
+// by the compiler: '.' is palette entry 0, '#' 1, '+' 2 and '*' 3.
+
+namespace {
+
+constexpr uint8_t pixelCode(char c) {
+  return c == '#' ? 1 : c == '+' ? 2 : c == '*' ? 3 : 0;
+}
+
+constexpr uint8_t packPixel(const char *row, uint8_t x) {
+  return x < CELL_SIZE ? pixelCode(row[x]) << (6 - 2 * (x & 3)) : 0;
+}
+
+constexpr uint8_t packByte(const char *row, uint8_t first) {
+  return packPixel(row, first) | packPixel(row, first + 1) | packPixel(row, first + 2) | packPixel(row, first + 3);
+}
+
+}
+
+#if CELL_SIZE == 10
+
+#define ROW(text) { packByte(text, 0), packByte(text, 4), packByte(text, 8) }
+
+const Sprite spriteAtlas[SPRITE_COUNT] PROGMEM = {
+  // SPRITE_SNAKE
+  { {ILI9341_BLACK, ILI9341_GREEN, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW("##########"), ROW("##########"), ROW("##########"), ROW("##########"), ROW("##########"),
+    ROW("##########"), ROW("##########"), ROW("##########"), ROW("##########"), ROW("##########") } },
+  // SPRITE_FOOD: the same pixels fillCircle(x + 5, y + 5, 4) sets
+  { {ILI9341_BLACK, ILI9341_ORANGE, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW(".........."), ROW("....###..."), ROW("..#######."), ROW("..#######."), ROW(".#########"),
+    ROW(".#########"), ROW(".#########"), ROW("..#######."), ROW("..#######."), ROW("....###...") } },
+  // SPRITE_BAD_FOOD
+  { {ILI9341_BLACK, ILI9341_RED, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW(".........."), ROW("....###..."), ROW("..#######."), ROW("..#######."), ROW(".#########"),
+    ROW(".#########"), ROW(".#########"), ROW("..#######."), ROW("..#######."), ROW("....###...") } },
+  // SPRITE_BARRIER: a "7" that stays inside its own cell
+  { {ILI9341_BLACK, ILI9341_RED, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW("##########"), ROW("##########"), ROW("......##.."), ROW("......##.."), ROW("....##...."),
+    ROW("....##...."), ROW("..##......"), ROW("..##......"), ROW("##........"), ROW("##........") } },
+};
+
+#elif CELL_SIZE == 5
+
+#define ROW(text) { packByte(text, 0), packByte(text, 4) }
+
+const Sprite spriteAtlas[SPRITE_COUNT] PROGMEM = {
+  // SPRITE_SNAKE
+  { {ILI9341_BLACK, ILI9341_GREEN, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW("#####"), ROW("#####"), ROW("#####"), ROW("#####"), ROW("#####") } },
+  // SPRITE_FOOD
+  { {ILI9341_BLACK, ILI9341_ORANGE, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW(".###."), ROW("#####"), ROW("#####"), ROW("#####"), ROW(".###.") } },
+  // SPRITE_BAD_FOOD
+  { {ILI9341_BLACK, ILI9341_RED, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW(".###."), ROW("#####"), ROW("#####"), ROW("#####"), ROW(".###.") } },
+  // SPRITE_BARRIER
+  { {ILI9341_BLACK, ILI9341_RED, ILI9341_BLACK, ILI9341_BLACK}, {
+    ROW("#####"), ROW("...#."), ROW("..#.."), ROW(".#..."), ROW("#....") } },
+};
+
+#else
+#error "no sprite art for this CELL_SIZE"
+#endif
+
+void spritePalette(SpriteId sprite, uint16_t *palette) {
+  memcpy_P(palette, spriteAtlas[sprite].palette, sizeof(spriteAtlas[sprite].palette));
+}
+
+void spriteRow(SpriteId sprite, uint8_t row, const uint16_t *palette, uint16_t *pixels) {
+  const uint8_t *packed = spriteAtlas[sprite].rows[row];
+  for (uint8_t x = 0; x < CELL_SIZE; x += 4) {
+    uint8_t four = pgm_read_byte(packed++);
+    for (uint8_t i = 0; i < 4 && x + i < CELL_SIZE; i++, four <<= 2) {
+      pixels[x + i] = palette[four >> 6];
+    }
+  }
+}
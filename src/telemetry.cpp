@@ -0,0 +1,168 @@
+#include <string.h>
+#include "telemetry.h"
+#include "hal.h"
+#include "crc16.h"
+
+#define FRAME_HEADER 4        // sync, type, sequence, length
+#define FRAME_CRC 2
+#define TICK_HEADER 2         // the tick in front of the ops
+#define SNAPSHOT_HEADER 4     // first cell, cols and rows in front of the cells
+#define REMOTE_PAYLOAD_MAX 1  // longest frame a host sends
+#define NO_SNAPSHOT 0xFFFF
+
+// Frames are built in place, the payload right behind the header
+static uint8_t frame[FRAME_HEADER + TELEMETRY_PAYLOAD_MAX + FRAME_CRC];
+static uint8_t *const payload = frame + FRAME_HEADER;
+static uint8_t opLength = TICK_HEADER;  // payload bytes of the tick being gathered
+static uint8_t sequence = 0;
+
+static const Game *board = 0;  // whose cells a snapshot reads
+static uint16_t points;        // last score sent, repeated by a snapshot
+static uint8_t level;
+static uint16_t snapshotNext = NO_SNAPSHOT;
+
+// A host frame coming in
+static uint8_t received[FRAME_HEADER + REMOTE_PAYLOAD_MAX + FRAME_CRC];
+static uint8_t receivedLength = 0;
+static char remoteTurn = 0;
+static bool linked = false;
+
+static bool sendFrame(uint8_t type, uint8_t length) {
+  // Seal the payload and hand the frame over; the sequence moves on once it is sent
+  frame[0] = TELEMETRY_SYNC;
+  frame[1] = type;
+  frame[2] = sequence;
+  frame[3] = length;
+  uint16_t crc = crc16(frame + 1, FRAME_HEADER - 1 + length);
+  payload[length] = crc;
+  payload[length + 1] = crc >> 8;
+  if (!halSerialSend(frame, FRAME_HEADER + length + FRAME_CRC)) return false;
+  sequence++;
+  return true;
+}
+
+static void resync() {
+  // SEND THE WHOLE BOARD AGAIN, A PART PER POLL
+  if (board) snapshotNext = 0;
+}
+
+static void flushOps() {
+  uint16_t tick = board ? board->ticks : 0;
+  payload[0] = tick;
+  payload[1] = tick >> 8;
+  if (!sendFrame(FRAME_TICK, opLength)) {
+    sequence++;  // skipped, so the host sees the gap
+    resync();
+  }
+  opLength = TICK_HEADER;
+}
+
+static void addOp(uint8_t op, uint8_t a, uint8_t b) {
+  if (opLength + 3 > TELEMETRY_PAYLOAD_MAX) flushOps();
+  payload[opLength++] = op;
+  payload[opLength++] = a;
+  payload[opLength++] = b;
+}
+
+void telemetryBegin(const Game &game, uint32_t seed, uint8_t mode) {
+  board = &game;
+  opLength = TICK_HEADER;
+  snapshotNext = NO_SNAPSHOT;
+  payload[0] = GRID_COLS;
+  payload[1] = GRID_ROWS;
+  memcpy(payload + 2, &seed, 4);  // little endian on both the AVR and the host
+  payload[6] = mode;
+  if (!sendFrame(FRAME_BEGIN, 7)) resync();
+}
+
+void telemetryErase(Cell cell) {
+  addOp(OP_ERASE, cell.col, cell.row);
+}
+
+void telemetryDraw(Cell cell, SpriteId sprite) {
+  addOp(OP_DRAW + sprite, cell.col, cell.row);
+}
+
+void telemetryScore(int score, int newLevel) {
+  points = score;
+  level = newLevel;
+  if (opLength + 4 > TELEMETRY_PAYLOAD_MAX) flushOps();
+  payload[opLength++] = OP_SCORE;
+  payload[opLength++] = points;
+  payload[opLength++] = points >> 8;
+  payload[opLength++] = level;
+}
+
+void telemetryTick() {
+  if (opLength > TICK_HEADER) flushOps();
+}
+
+static uint8_t cellCode(uint16_t index) {
+  // Sprite + 1 of what is on a cell, 0 for nothing
+  if (index >= GRID_CELLS) return 0;
+  Cell cell = cellAt(index);
+  if (board->bodyGrid.test(cell)) return SPRITE_SNAKE + 1;
+  if (board->barrierGrid.test(cell)) return SPRITE_BARRIER + 1;
+  if (board->badFoodGrid.test(cell)) return SPRITE_BAD_FOOD + 1;
+  if (cell == board->food) return SPRITE_FOOD + 1;
+  return 0;
+}
+
+void telemetryPoll() {
+  // A snapshot reads the board as it is now. Moves keep being sent
+  // meanwhile, and applying them on top of it leaves the same board.
+  if (snapshotNext == NO_SNAPSHOT || opLength > TICK_HEADER) return;
+  uint16_t first = snapshotNext;
+  payload[0] = first;
+  payload[1] = first >> 8;
+  payload[2] = GRID_COLS;
+  payload[3] = GRID_ROWS;
+  uint8_t length = SNAPSHOT_HEADER;
+  for (uint16_t i = first; i < first + TELEMETRY_CHUNK_CELLS && i < GRID_CELLS; i += 2) {
+    payload[length++] = cellCode(i) | cellCode(i + 1) << 4;
+  }
+  if (!sendFrame(FRAME_SNAPSHOT, length)) return;  // try again on the next poll
+  snapshotNext = first + TELEMETRY_CHUNK_CELLS < GRID_CELLS ? first + TELEMETRY_CHUNK_CELLS : NO_SNAPSHOT;
+  if (snapshotNext == NO_SNAPSHOT) {
+    telemetryScore(points, level);
+    flushOps();
+  }
+}
+
+Remote telemetryReceive(uint8_t byte) {
+  // COLLECT A HOST FRAME, ACT ON IT ONCE ITS CRC CHECKS OUT
+  if (receivedLength == 0 && byte != TELEMETRY_SYNC) return REMOTE_TEXT;
+  received[receivedLength++] = byte;
+  if (receivedLength < FRAME_HEADER) return REMOTE_NONE;
+  uint8_t length = received[3];
+  if (length > REMOTE_PAYLOAD_MAX) {
+    receivedLength = 0;  // not a host frame, start over at the next sync byte
+    return REMOTE_NONE;
+  }
+  if (receivedLength < FRAME_HEADER + length + FRAME_CRC) return REMOTE_NONE;
+  receivedLength = 0;
+
+  const uint8_t *body = received + FRAME_HEADER;
+  if ((body[length] | body[length + 1] << 8) != crc16(received + 1, FRAME_HEADER - 1 + length)) return REMOTE_NONE;
+  linked = true;
+  switch (received[1]) {
+    case FRAME_STEER:
+      if (length != 1 || !body[0] || !strchr("udlr", body[0])) break;
+      remoteTurn = body[0];
+      return REMOTE_STEER;
+    case FRAME_BUTTON:
+      return REMOTE_BUTTON;
+    case FRAME_RESYNC:
+      resync();
+      break;
+  }
+  return REMOTE_NONE;
+}
+
+char telemetryRemoteTurn() {
+  return remoteTurn;
+}
+
+bool telemetryLinked() {
+  return linked;
+}
@@ -0,0 +1,285 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sim.h"
+#include "autopilot.h"
+
+//=================================================================
+// Tournament: many seeded games of the game rules, spread over every
+// core of the host, for balancing the level curve and checking rule
+// changes. Each game is played from its seed by one policy until the
+// snake crashes or the move limit runs out. Every game is one CSV row
+// on stdout, written as soon as its batch is done, and a summary goes
+// to stderr at the end. Rows come in the order batches finish; sort by
+// seed for a stable file.
+//
+//   pio run -e tournament && .pio/build/tournament/program -n 1000000 -p autopilot > games.csv
+//
+//   -n games    games to play (default 10000)
+//   -p policy   sweep, chase, autopilot or random (default chase)
+//   -s seed     first seed, the games use seed, seed + 1, ... (default 1)
+//   -j threads  workers (default: one per core)
+//   -t moves    move limit of a game (default 100000)
+
+#define DEFAULT_GAMES 10000
+#define DEFAULT_MOVE_LIMIT 100000UL
+#define BATCH_GAMES 64      // games a worker takes at a time, and rows it writes at once
+#define RNG_STREAM_POLICY 3 // after the engine's streams, so random input never disturbs a spawn
+
+//=================================================================
+// Policies: who plays the games
+
+struct Player {
+  uint32_t phase;  // moves made, for the sweep
+  Rng rng;
+  Autopilot autopilot;
+};
+
+// Right along a row, then one down, ignoring the food
+static char sweep(Sim &, Player &player) {
+  return player.phase++ % GRID_COLS == GRID_COLS - 1 ? 'd' : 'r';
+}
+
+static char chase(Sim &sim, Player &) {
+  return simChase(sim.game, 0);
+}
+
+static char followAutopilot(Sim &sim, Player &player) {
+  autopilotThink(player.autopilot, sim.game, AUTOPILOT_BUDGET);
+  return autopilotSteer(player.autopilot, sim.game);
+}
+
+// A turn on one move in eight, the way a distracted player steers
+static char wander(Sim &, Player &player) {
+  return player.rng.below(8) == 0 ? "rlud"[player.rng.below(4)] : 0;
+}
+
+struct Policy {
+  const char *name;
+  char (*steer)(Sim &sim, Player &player);
+};
+
+static const Policy policies[] = {
+  { "sweep", sweep },
+  { "chase", chase },
+  { "autopilot", followAutopilot },
+  { "random", wander },
+};
+
+static const char *const causes[] = { "none", "body", "barrier", "head_on", "move_limit" };
+#define CAUSE_MOVE_LIMIT 4
+
+//=================================================================
+// Results
+
+struct Totals {
+  uint32_t games;
+  uint32_t wrapped;  // games whose score wrapped below 0, left out of the score and level figures
+  uint64_t moves;
+  uint64_t scoreSum;
+  uint64_t scoreSquares;
+  uint16_t bestScore;
+  uint32_t causes[CAUSE_MOVE_LIMIT + 1];
+  uint32_t reached[MAX_LEVEL + 1];  // games that got to each level, even if bad food took them back down
+
+  void add(const Totals &other) {
+    games += other.games;
+    wrapped += other.wrapped;
+    moves += other.moves;
+    scoreSum += other.scoreSum;
+    scoreSquares += other.scoreSquares;
+    if (other.bestScore > bestScore) bestScore = other.bestScore;
+    for (uint8_t i = 0; i <= CAUSE_MOVE_LIMIT; i++) causes[i] += other.causes[i];
+    for (uint8_t i = 0; i <= MAX_LEVEL; i++) reached[i] += other.reached[i];
+  }
+};
+
+struct Options {
+  uint32_t games;
+  uint32_t firstSeed;
+  uint32_t moveLimit;
+  unsigned threads;
+  const Policy *policy;
+};
+
+// Play one game from its seed and append its row
+static void play(const Options &options, uint32_t seed, Sim &sim, Player &player, std::string &rows, Totals &totals) {
+  player.phase = 0;
+  player.rng.seed(seed, RNG_STREAM_POLICY);
+  autopilotBegin(player.autopilot);
+  simBegin(sim, seed);
+
+  while (sim.stats.ticks < options.moveLimit && simTick(sim, options.policy->steer(sim, player))) {
+  }
+
+  const Game &game = sim.game;
+  uint8_t cause = game.over ? game.crash[0] : CAUSE_MOVE_LIMIT;
+  unsigned short score = game.points[0];
+  unsigned short level = game.level > MAX_LEVEL ? MAX_LEVEL : game.level;
+  unsigned short peak = sim.stats.peakLevel > MAX_LEVEL ? MAX_LEVEL : sim.stats.peakLevel;
+
+  char row[128];
+  snprintf(row, sizeof(row), "%lu,%s,%u,%u,%u,%u,%lu,%lu,%lu,%u,%s,%u\n",
+           (unsigned long)seed, options.policy->name, score, game.snakes.length[0], level, peak,
+           (unsigned long)sim.stats.ticks, (unsigned long)sim.stats.foodEaten,
+           (unsigned long)sim.stats.badFoodEaten, game.foodMissed, causes[cause], sim.stats.scoreWrapped);
+  rows += row;
+
+  totals.games++;
+  totals.moves += sim.stats.ticks;
+  totals.causes[cause]++;
+  if (sim.stats.scoreWrapped) {
+    totals.wrapped++;
+    return;
+  }
+  totals.scoreSum += score;
+  totals.scoreSquares += (uint64_t)score * score;
+  if (score > totals.bestScore) totals.bestScore = score;
+  for (unsigned short i = 1; i <= peak; i++) totals.reached[i]++;
+}
+
+//=================================================================
+// Work-stealing pool. Each worker owns a deque of batches of seeds: it
+// takes from the back of its own and, once that runs dry, steals from
+// the front of the others', so a worker that drew long games is helped
+// out instead of holding up the end of the run.
+
+struct Batch {
+  uint32_t firstSeed;
+  uint32_t games;
+};
+
+struct Worker {
+  std::mutex lock;
+  std::deque<Batch> batches;
+  Totals totals;
+};
+
+static std::mutex outputLock;
+
+static bool takeBatch(std::vector<Worker> &workers, size_t self, Batch &batch) {
+  {
+    std::lock_guard<std::mutex> guard(workers[self].lock);
+    if (!workers[self].batches.empty()) {
+      batch = workers[self].batches.back();
+      workers[self].batches.pop_back();
+      return true;
+    }
+  }
+  for (size_t i = 1; i < workers.size(); i++) {
+    Worker &victim = workers[(self + i) % workers.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.batches.empty()) {
+      batch = victim.batches.front();
+      victim.batches.pop_front();
+      return true;
+    }
+  }
+  return false;  // batches never spawn more, so every deque is empty for good
+}
+
+static void work(const Options &options, std::vector<Worker> &workers, size_t self) {
+  // Game state is a few hundred bytes, each worker keeps its own
+  Sim *sim = new Sim();
+  Player *player = new Player();
+  std::string rows;
+  Batch batch;
+  while (takeBatch(workers, self, batch)) {
+    rows.clear();
+    for (uint32_t i = 0; i < batch.games; i++) {
+      play(options, batch.firstSeed + i, *sim, *player, rows, workers[self].totals);
+    }
+    std::lock_guard<std::mutex> guard(outputLock);
+    fwrite(rows.data(), 1, rows.size(), stdout);
+  }
+  delete player;
+  delete sim;
+}
+
+//=================================================================
+
+static void usage(const char *program) {
+  fprintf(stderr, "usage: %s [-n games] [-p sweep|chase|autopilot|random] [-s first seed] [-j threads] [-t move limit]\n", program);
+}
+
+static void summary(const Options &options, const Totals &totals, double seconds) {
+  uint32_t scored = totals.games - totals.wrapped;
+  double mean = scored ? (double)totals.scoreSum / scored : 0;
+  double variance = scored ? (double)totals.scoreSquares / scored - mean * mean : 0;
+  fprintf(stderr, "%lu games of %s on %u threads in %.2f s, %.0f games/s, %.0f moves/s\n",
+          (unsigned long)totals.games, options.policy->name, options.threads, seconds,
+          totals.games / seconds, totals.moves / seconds);
+  fprintf(stderr, "score   mean %.2f, sd %.2f, best %u\n", mean, variance > 0 ? sqrt(variance) : 0.0, totals.bestScore);
+  if (totals.wrapped) fprintf(stderr, "wrapped %lu games ate bad food at score 0, left out of score and reached\n", (unsigned long)totals.wrapped);
+  fprintf(stderr, "moves   mean %.1f\n", totals.games ? (double)totals.moves / totals.games : 0);
+  fprintf(stderr, "ended  ");
+  for (uint8_t i = 1; i <= CAUSE_MOVE_LIMIT; i++) fprintf(stderr, " %s %lu", causes[i], (unsigned long)totals.causes[i]);
+  fprintf(stderr, "\nreached");
+  for (uint8_t level = 1; level <= MAX_LEVEL && totals.reached[level]; level++) {
+    fprintf(stderr, " %u:%.1f%%", level, 100.0 * totals.reached[level] / scored);
+  }
+  fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  options.games = DEFAULT_GAMES;
+  options.firstSeed = 1;
+  options.moveLimit = DEFAULT_MOVE_LIMIT;
+  options.threads = std::thread::hardware_concurrency();
+  options.policy = &policies[1];
+  if (options.threads == 0) options.threads = 1;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:p:s:j:t:")) != -1) {
+    switch (option) {
+      case 'n': options.games = strtoul(optarg, 0, 0); break;
+      case 's': options.firstSeed = strtoul(optarg, 0, 0); break;
+      case 'j': options.threads = strtoul(optarg, 0, 0); break;
+      case 't': options.moveLimit = strtoul(optarg, 0, 0); break;
+      case 'p':
+        options.policy = 0;
+        for (uint8_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+          if (strcmp(optarg, policies[i].name) == 0) options.policy = &policies[i];
+        }
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if (!options.policy || options.threads == 0 || options.moveLimit == 0 || optind != argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // Deal the batches out round robin, stealing evens out the rest
+  std::vector<Worker> workers(options.threads);
+  for (uint32_t first = 0, n = 0; first < options.games; first += BATCH_GAMES, n++) {
+    Batch batch = { options.firstSeed + first, options.games - first < BATCH_GAMES ? options.games - first : BATCH_GAMES };
+    workers[n % options.threads].batches.push_back(batch);
+  }
+  for (size_t i = 0; i < workers.size(); i++) memset(&workers[i].totals, 0, sizeof(Totals));
+
+  printf("seed,policy,score,length,level,peak_level,moves,food,bad_food,food_missed,cause,wrapped\n");
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers.size(); i++) threads.push_back(std::thread(work, std::cref(options), std::ref(workers), i));
+  for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fflush(stdout);
+
+  Totals totals;
+  memset(&totals, 0, sizeof(totals));
+  for (size_t i = 0; i < workers.size(); i++) totals.add(workers[i].totals);
+  summary(options, totals, seconds);
+  return 0;
+}